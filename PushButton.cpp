@@ -5,9 +5,8 @@ PushButton::PushButton(uint8_t pin)
 {
 }
 
-void PushButton::trigger()
+void PushButton::trigger(Clock::Time time)
 {
-    uint32_t time{millis()};
     if (m_state == State::Idle && time - m_last_pressed_time >= BUTTON_MIN_REPEAT_TIME) {
         m_state = State::Unconfirmed;
         m_trigger_time = time;
@@ -16,7 +15,7 @@ void PushButton::trigger()
 
 void PushButton::update()
 {
-    uint32_t time{millis()};
+    const auto time{Clock::now()};
     if (m_state == State::Unconfirmed && (time - m_trigger_time) >= BUTTON_DEBOUNCE_TIME) {
         if (digitalRead(m_pin) == HIGH) {
             m_state = State::Pressed;
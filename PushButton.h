@@ -1,6 +1,7 @@
 #pragma once
 
 #include "button.h"
+#include "clock.h"
 #include <Arduino.h>
 
 #define BUTTON_DEBOUNCE_TIME 50
@@ -10,7 +11,7 @@ class PushButton : public Button {
 public:
     PushButton(uint8_t);
 
-    void trigger() final;
+    void trigger(Clock::Time time) final;
 
     void update() final;
 
@@ -18,7 +19,7 @@ public:
 
 private:
     uint8_t m_pin;
-    uint32_t m_trigger_time{0};
-    uint32_t m_last_pressed_time{0};
+    Clock::Time m_trigger_time{0};
+    Clock::Time m_last_pressed_time{0};
     State m_state{State::Idle};
 };
@@ -34,8 +34,10 @@ const int8_t KNOBDIR[] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
 RotaryEncoder::RotaryEncoder(int pin1, int pin2, LatchMode mode)
 {
     // Remember Hardware Setup
-    _pin1 = pin1;
-    _pin2 = pin2;
+    _port1 = portInputRegister(digitalPinToPort(pin1));
+    _port2 = portInputRegister(digitalPinToPort(pin2));
+    _mask1 = digitalPinToBitMask(pin1);
+    _mask2 = digitalPinToBitMask(pin2);
     _mode = mode;
 
     // Setup the input pins and turn on pullup resistor
@@ -43,41 +45,22 @@ RotaryEncoder::RotaryEncoder(int pin1, int pin2, LatchMode mode)
     pinMode(pin2, INPUT_PULLUP);
 
     // when not started in motion, the current state of the encoder should be 3
-    int sig1 = digitalRead(_pin1);
-    int sig2 = digitalRead(_pin2);
-    _oldState = sig1 | (sig2 << 1);
+    _oldState = readState();
 
     // start with position 0;
     _position = 0;
     _positionExt = 0;
-    _positionExtPrev = 0;
 } // RotaryEncoder()
 
-RotaryEncoder::Direction RotaryEncoder::getDirection()
+int8_t RotaryEncoder::readState() const
 {
-    RotaryEncoder::Direction ret = Direction::NOROTATION;
-
-    if (_positionExtPrev > _positionExt) {
-        ret = Direction::COUNTERCLOCKWISE;
-        _positionExtPrev = _positionExt;
-    }
-    else if (_positionExtPrev < _positionExt) {
-        ret = Direction::CLOCKWISE;
-        _positionExtPrev = _positionExt;
-    }
-    else {
-        ret = Direction::NOROTATION;
-        _positionExtPrev = _positionExt;
-    }
-
-    return ret;
-}
-
-void RotaryEncoder::tick(void)
+    return ((*_port1 & _mask1) ? 1 : 0) | ((*_port2 & _mask2) ? 2 : 0);
+} // readState()
+
+int8_t RotaryEncoder::tick(void)
 {
-    int sig1 = digitalRead(_pin1);
-    int sig2 = digitalRead(_pin2);
-    int8_t thisState = sig1 | (sig2 << 1);
+    const long previous = _positionExt;
+    int8_t thisState = readState();
 
     if (_oldState != thisState) {
         _position += KNOBDIR[thisState | (_oldState << 2)];
@@ -106,4 +89,6 @@ void RotaryEncoder::tick(void)
                 break;
         } // switch
     }     // if
+
+    return static_cast<int8_t>(_positionExt - previous);
 } // tick()
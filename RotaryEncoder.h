@@ -22,8 +22,6 @@
 
 class RotaryEncoder {
 public:
-    enum class Direction { NOROTATION = 0, CLOCKWISE = 1, COUNTERCLOCKWISE = -1 };
-
     enum class LatchMode {
         FOUR3 = 1, // 4 steps, Latch at position 3 only (compatible to older versions)
         FOUR0 = 2, // 4 steps, Latch at position 0 (reverse wirings)
@@ -33,22 +31,24 @@ public:
     // ----- Constructor -----
     RotaryEncoder(int pin1, int pin2, LatchMode mode = LatchMode::FOUR0);
 
-    // simple retrieve of the direction the knob was rotated last time. 0 = No rotation, 1 = Clockwise, -1 = Counter Clockwise
-    Direction getDirection();
-
     // call this function every some milliseconds or by using an interrupt for handling state changes of the rotary encoder.
-    void tick(void);
+    // returns the number of latched steps since the last call, positive clockwise.
+    int8_t tick(void);
 
 private:
-    int _pin1, _pin2; // Arduino pins used for the encoder.
+    // read both pins straight from their port input registers, cheap enough for interrupts.
+    int8_t readState() const;
+
+    volatile uint8_t* _port1; // Input registers and bit masks of the pins used for the encoder.
+    volatile uint8_t* _port2;
+    uint8_t _mask1, _mask2;
 
     LatchMode _mode; // Latch mode from initialization
 
     volatile int8_t _oldState;
 
-    volatile long _position;        // Internal position (4 times _positionExt)
-    volatile long _positionExt;     // External position
-    volatile long _positionExtPrev; // External position (used only for direction checking)
+    volatile long _position;    // Internal position (4 times _positionExt)
+    volatile long _positionExt; // External position
 };
 
 #endif
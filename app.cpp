@@ -1,4 +1,6 @@
+#if defined(HAVE_CONFIG_H)
 #include "config.h"
+#endif
 
 #include <Arduino.h>
 
@@ -7,7 +9,13 @@
 #include "comm.h"
 #include "controller.h"
 #include "hotplate.h"
+#include "input.h"
+#include "input_trace.h"
+#include "memory.h"
+#include "schedule.h"
 #include "sensor.h"
+#include "tasks.h"
+#include "timing.h"
 #include "ui.h"
 
 #if defined(WITH_DS18B20)
@@ -35,7 +43,7 @@ MockTemperatureSensor sparging_sensor;
 
 #if defined(WITH_KY040)
 #include "ky040.h"
-Ky040 encoder{KY040_SW, KY040_DT, KY040_CLK};
+Ky040 encoder{KY040_SW, KY040_DT, KY040_CLK, Ky040::Acceleration{KY040_ACCELERATION, KY040_ACCELERATION_SLOW, KY040_ACCELERATION_FAST}};
 #define ENCODER_MESSAGE " +ky040"
 #else
 #include "encoder.h"
@@ -110,40 +118,55 @@ ISR(PCINT1_vect)
 
 void brew_button_trigger()
 {
-    brew_button.trigger();
+    input::push(input::Source::brew_button);
 }
 
 void sparging_button_trigger()
 {
-    sparging_button.trigger();
+    input::push(input::Source::sparging_button);
 }
 
-Comm comm{controller};
+Schedule brew_schedule{controller, Controller::Channel::brew};
+Schedule sparging_schedule{controller, Controller::Channel::sparging};
+
+#if defined(RS485_ADDRESS)
+Comm comm{controller, brew_schedule, sparging_schedule, RS485_ADDRESS};
+#else
+Comm comm{controller, brew_schedule, sparging_schedule};
+#endif
 
 class App {
 public:
-    App(Ui& ui, Controller& controller, TemperatureSensor& sparging_sensor, ButtonEncoder& encoder)
+    App(Ui& ui, Controller& controller, TemperatureSensor& sparging_sensor)
     : m_ui{ui}
     , m_controller{controller}
     , m_sparging_sensor{sparging_sensor}
-    , m_encoder{encoder}
-    , m_last_update{millis()}
+    , m_last_update{Clock::now()}
     {
     }
 
-    void update()
+    /**
+     * Run control loop and schedules.
+     */
+    void update_control(Clock::Time now)
     {
-        const auto now{millis()};
         const auto elapsed{now - m_last_update};
         m_last_update = now;
 
         m_controller.update(elapsed);
+        brew_schedule.update(elapsed);
+        sparging_schedule.update(elapsed);
+    }
 
-        auto brew_target_temperature{m_controller.brew_target_temperature()};
-        auto sparging_target_temperature{m_controller.sparging_target_temperature()};
-
+    /**
+     * Handle user input and refresh the display.
+     */
+    void update_ui(Clock::Time now)
+    {
         // enable layout switching only after welcome message, approx. 15 s
-        if (now > 15000) {
+        m_welcome_done = m_welcome_done || now > 15000;
+
+        if (m_welcome_done) {
             // disable layout B if sparging sensor disconnected for some time
             if (m_sparging_sensor.last_seen() < 15000) {
                 ui.set_layout_switching(true);
@@ -154,47 +177,29 @@ public:
             }
         }
 
-        if (m_encoder.pressed()) {
-            switch (m_state) {
-                case State::SetTarget: {
-                    m_state = State::Main;
-                    switch (ui.freeze_layout(false)) {
-                        case Ui::Layout::LayoutA:
-                            brew_target_temperature = static_cast<float>(m_set_target_temperature);
-                            m_controller.set_brew_temperature(brew_target_temperature);
-                            break;
-                        case Ui::Layout::LayoutB:
-                            sparging_target_temperature = static_cast<float>(m_set_target_temperature);
-                            m_controller.set_sparging_temperature(sparging_target_temperature);
-                            break;
-                    }
+        input::Event event;
+
+        // Everything the interrupts queued since the last pass, in order.
+        while (input::pop(event)) {
+            switch (event.source) {
+                case input::Source::encoder:
+                    turn(event.steps);
                     break;
-                }
-                case State::Main: {
-                    switch (ui.freeze_layout(true)) {
-                        case Ui::Layout::LayoutA:
-                            if (brew_target_temperature == 0.0f) {
-                                m_set_target_temperature = static_cast<uint8_t>(round(m_controller.brew_temperature()));
-                            }
-                            else {
-                                m_set_target_temperature = static_cast<uint8_t>(round(brew_target_temperature));
-                            }
-                            break;
-                        case Ui::Layout::LayoutB:
-                            if (sparging_target_temperature == 0.0f) {
-                                m_set_target_temperature = static_cast<uint8_t>(round(m_controller.sparging_temperature()));
-                            }
-                            else {
-                                m_set_target_temperature = static_cast<uint8_t>(round(sparging_target_temperature));
-                            }
-                            break;
-                    }
-                    m_state = State::SetTarget;
+                case input::Source::encoder_switch:
+                    press();
+                    break;
+                case input::Source::brew_button:
+                    brew_button.trigger(event.time);
+                    break;
+                case input::Source::sparging_button:
+                    sparging_button.trigger(event.time);
                     break;
-                }
             }
         }
 
+        const auto brew_target_temperature{m_controller.brew_target_temperature()};
+        const auto sparging_target_temperature{m_controller.sparging_target_temperature()};
+
         const auto current_brew_temperature{m_controller.brew_temperature()};
         const auto current_sparging_temperature{m_controller.sparging_temperature()};
 
@@ -208,24 +213,8 @@ public:
                 break;
 
             case State::SetTarget: {
-                const auto direction{m_encoder.direction()};
-
-                if (direction == ButtonEncoder::Direction::Clockwise && m_set_target_temperature < 100) {
-                    m_set_target_temperature++;
-                }
-                else if (direction == ButtonEncoder::Direction::CounterClockwise && m_set_target_temperature > 0) {
-                    m_set_target_temperature--;
-                }
-
-                uint8_t current_target;
-                switch (ui.current_layout()) {
-                    case Ui::Layout::LayoutA:
-                        current_target = static_cast<uint8_t>(round(brew_target_temperature));
-                        break;
-                    case Ui::Layout::LayoutB:
-                        current_target = static_cast<uint8_t>(round(sparging_target_temperature));
-                        break;
-                }
+                const float target{ui.current_layout() == Ui::Layout::LayoutA ? brew_target_temperature : sparging_target_temperature};
+                const uint8_t current_target{static_cast<uint8_t>(round(target))};
 
                 if (m_set_target_temperature > current_target) {
                     m_ui_state &= ~(Ui::State::SmallDownArrow | Ui::State::SmallEq);
@@ -356,6 +345,11 @@ public:
             hotplate.state() ? hotplate.stop() : hotplate.start();
         }
 
+        if (comm.take_memory_display_request()) {
+            memory::format(memory::usage(), m_memory_message, sizeof(m_memory_message));
+            m_ui.show_message(m_memory_message);
+        }
+
         m_ui.set_state(m_ui_state);
         m_ui.update();
     }
@@ -366,6 +360,63 @@ private:
         SetTarget,
     };
 
+    /**
+     * Enter target entry for the visible layout or apply the entered target.
+     */
+    void press()
+    {
+        switch (m_state) {
+            case State::SetTarget: {
+                m_state = State::Main;
+                switch (ui.freeze_layout(false)) {
+                    case Ui::Layout::LayoutA:
+                        m_controller.set_brew_temperature(static_cast<float>(m_set_target_temperature));
+                        break;
+                    case Ui::Layout::LayoutB:
+                        m_controller.set_sparging_temperature(static_cast<float>(m_set_target_temperature));
+                        break;
+                }
+                break;
+            }
+            case State::Main: {
+                const auto brew_target_temperature{m_controller.brew_target_temperature()};
+                const auto sparging_target_temperature{m_controller.sparging_target_temperature()};
+
+                switch (ui.freeze_layout(true)) {
+                    case Ui::Layout::LayoutA:
+                        if (brew_target_temperature == 0.0f) {
+                            m_set_target_temperature = static_cast<uint8_t>(round(m_controller.brew_temperature()));
+                        }
+                        else {
+                            m_set_target_temperature = static_cast<uint8_t>(round(brew_target_temperature));
+                        }
+                        break;
+                    case Ui::Layout::LayoutB:
+                        if (sparging_target_temperature == 0.0f) {
+                            m_set_target_temperature = static_cast<uint8_t>(round(m_controller.sparging_temperature()));
+                        }
+                        else {
+                            m_set_target_temperature = static_cast<uint8_t>(round(sparging_target_temperature));
+                        }
+                        break;
+                }
+                m_state = State::SetTarget;
+                break;
+            }
+        }
+    }
+
+    /**
+     * Move the entered target by @p steps degrees, turns outside target
+     * entry are ignored.
+     */
+    void turn(int8_t steps)
+    {
+        if (m_state == State::SetTarget) {
+            m_set_target_temperature = static_cast<uint8_t>(constrain(m_set_target_temperature + steps, 0, 100));
+        }
+    }
+
     uint8_t binary_digit_sum(uint8_t value)
     {
         uint8_t n_bits = 0;
@@ -381,20 +432,67 @@ private:
     uint8_t m_ui_state{0};
     Controller& m_controller;
     TemperatureSensor& m_sparging_sensor;
-    ButtonEncoder& m_encoder;
     State m_state{State::Main};
     float m_last_brew_temperature{20.0f};
     float m_last_sparging_temperature{20.0f};
     uint8_t m_set_target_temperature{0};
-    unsigned long m_last_update{0};
-    unsigned long m_last_gradient{0};
+    bool m_welcome_done{false};
+    Clock::Time m_last_update{0};
+    Clock::Time m_last_gradient{0};
     uint8_t m_brew_gradient_up{0};
     uint8_t m_brew_gradient_down{0};
     uint8_t m_sparging_gradient_up{0};
     uint8_t m_sparging_gradient_down{0};
+    /// Scrolled by the Ui after a read_memory request.
+    char m_memory_message[48];
+};
+
+App app{ui, controller, sparging_sensor};
+
+void sensor_task(Clock::Time)
+{
+    TIMING(sensor);
+    brew_sensor.update();
+    sparging_sensor.update();
+
+    INPUT_TRACE_SENSOR(Controller::Channel::brew, brew_sensor);
+    INPUT_TRACE_SENSOR(Controller::Channel::sparging, sparging_sensor);
+}
+
+void gbc_task(Clock::Time)
+{
+    TIMING(gbc);
+    gbc.update();
+}
+
+void control_task(Clock::Time now)
+{
+    TIMING(control);
+    app.update_control(now);
+}
+
+void ui_task(Clock::Time now)
+{
+    TIMING(ui);
+    app.update_ui(now);
+}
+
+void comm_task(Clock::Time)
+{
+    TIMING(comm);
+    comm.process_serial_data();
+}
+
+// Ordered by priority, periods and deadlines in milliseconds.
+Task tasks[] = {
+    {comm_task, 0, 0},
+    {gbc_task, 50, 50},
+    {sensor_task, 188, 100},
+    {control_task, 1000, 500},
+    {ui_task, 15, 100},
 };
 
-App app{ui, controller, sparging_sensor, encoder};
+TaskScheduler scheduler{tasks, sizeof(tasks) / sizeof(tasks[0])};
 
 void setup()
 {
@@ -402,7 +500,7 @@ void setup()
     pinMode(13, OUTPUT);
     digitalWrite(13, LOW);
 
-    Serial.begin(115200, SERIAL_8N1);
+    comm.begin();
 
 #if defined(BREW_BUTTON_PIN)
     attachInterrupt(digitalPinToInterrupt(BREW_BUTTON_PIN), brew_button_trigger, RISING);
@@ -411,20 +509,32 @@ void setup()
     attachInterrupt(digitalPinToInterrupt(SPARGING_BUTTON_PIN), sparging_button_trigger, RISING);
 #endif
 
+#if !defined(WITH_MOCK_CONTROLLER)
+#if defined(BREW_CONTROL_PREDICTIVE)
+    controller.set_brew_mode(MainController::Mode::predictive);
+#elif defined(BREW_CONTROL_PID)
+    controller.set_brew_mode(MainController::Mode::pid);
+#endif
+#if defined(SPARGING_CONTROL_PID)
+    controller.set_sparging_mode(MainController::Mode::pid);
+#endif
+#endif // WITH_MOCK_CONTROLLER
+
     brew_sensor.begin();
     sparging_sensor.begin();
 
     display.begin();
     gbc.begin();
     hotplate.begin(); // ensure that relay is off at start
-}
 
-void serialEvent()
-{
-    comm.process_serial_data();
+    scheduler.begin();
 }
 
 void loop()
 {
-    app.update();
+    TIMING(loop);
+    // Levels of the polled button and GBC pins, input::push() records the
+    // encoder and button interrupts.
+    INPUT_TRACE_PINS();
+    scheduler.run();
 }
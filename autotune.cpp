@@ -0,0 +1,104 @@
+#include "autotune.h"
+
+namespace {
+    /// Relay hysteresis in degree Celsius, roughly the sensor quantization.
+    constexpr float band{0.25f};
+    /// Number of initial cycles ignored while the oscillation settles.
+    constexpr uint8_t skip_cycles{1};
+    /// Number of cycles averaged for the estimate.
+    constexpr uint8_t measure_cycles{3};
+    /// Give up after four hours.
+    constexpr unsigned long timeout{4UL * 3600UL * 1000UL};
+    /// Relay amplitude for an output switching between 0 and 1.
+    constexpr float relay_amplitude{0.5f};
+}
+
+void RelayTuner::start(float setpoint, unsigned long now)
+{
+    m_state = State::running;
+    m_setpoint = setpoint;
+    m_on = true;
+    m_start = now;
+    m_has_off = false;
+    m_cycles = 0;
+    m_period_sum = 0.0f;
+    m_amplitude_sum = 0.0f;
+}
+
+void RelayTuner::cancel()
+{
+    if (m_state == State::running) {
+        m_state = State::idle;
+    }
+}
+
+bool RelayTuner::update(float temperature, unsigned long now)
+{
+    if (m_state != State::running) {
+        return false;
+    }
+
+    if (now - m_start > timeout) {
+        m_state = State::failed;
+        return false;
+    }
+
+    m_high = max(m_high, temperature);
+    m_low = min(m_low, temperature);
+
+    if (m_on && temperature > m_setpoint + band) {
+        m_on = false;
+
+        // Two consecutive off switches enclose one full cycle with one peak and one trough.
+        if (m_has_off) {
+            if (m_cycles >= skip_cycles) {
+                m_period_sum += (now - m_last_off) / 1000.0f;
+                m_amplitude_sum += (m_high - m_low) / 2.0f;
+            }
+
+            if (++m_cycles == skip_cycles + measure_cycles) {
+                finish();
+                return false;
+            }
+        }
+
+        m_has_off = true;
+        m_last_off = now;
+        m_high = temperature;
+        m_low = temperature;
+    }
+    else if (!m_on && temperature < m_setpoint - band) {
+        m_on = true;
+    }
+
+    return m_on;
+}
+
+RelayTuner::State RelayTuner::state() const
+{
+    return m_state;
+}
+
+const Gains& RelayTuner::gains() const
+{
+    return m_gains;
+}
+
+void RelayTuner::finish()
+{
+    const float amplitude{m_amplitude_sum / measure_cycles};
+    const float period{m_period_sum / measure_cycles};
+
+    if (amplitude < 0.01f || period < 1.0f) {
+        m_state = State::failed;
+        return;
+    }
+
+    const float ultimate_gain{4.0f * relay_amplitude / (static_cast<float>(PI) * amplitude)};
+
+    // Classic Ziegler–Nichols rules.
+    m_gains.kp = 0.6f * ultimate_gain;
+    m_gains.ki = m_gains.kp / (0.5f * period);
+    m_gains.kd = m_gains.kp * 0.125f * period;
+    m_state = State::done;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "pid.h"
+#include <Arduino.h>
+
+/**
+ * Åström–Hägglund relay feedback experiment.
+ *
+ * Switches an on/off actuator around a setpoint and measures amplitude and
+ * period of the resulting limit cycle. From the ultimate gain and period,
+ * Ziegler–Nichols PID gains are derived.
+ */
+class RelayTuner {
+public:
+    enum class State : uint8_t {
+        idle = 0,
+        running = 1,
+        done = 2,
+        failed = 3,
+    };
+
+    /**
+     * Begin a new experiment.
+     *
+     * @param setpoint Temperature in degree Celsius to oscillate around.
+     * @param now Current time in milliseconds.
+     */
+    void start(float setpoint, unsigned long now);
+
+    /**
+     * Abort a running experiment.
+     */
+    void cancel();
+
+    /**
+     * Feed a new temperature reading.
+     *
+     * @return @c true if the actuator should be on.
+     */
+    bool update(float temperature, unsigned long now);
+
+    State state() const;
+
+    /**
+     * Derived gains, valid once state() is State::done.
+     */
+    const Gains& gains() const;
+
+private:
+    void finish();
+
+    State m_state{State::idle};
+    float m_setpoint{0.0f};
+    bool m_on{false};
+    unsigned long m_start{0};
+    unsigned long m_last_off{0};
+    bool m_has_off{false};
+    float m_high{0.0f};
+    float m_low{0.0f};
+    uint8_t m_cycles{0};
+    float m_period_sum{0.0f};
+    float m_amplitude_sum{0.0f};
+    Gains m_gains{};
+};
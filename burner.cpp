@@ -22,7 +22,7 @@ void MockGasBurner::stop() {}
 
 void MockGasBurner::update()
 {
-    const auto now{millis()};
+    const auto now{Clock::now()};
 
     if (now - m_last_state_change_time >= 2000) {
         m_last_state_change_time = now;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "clock.h"
 #include <Arduino.h>
 
 /**
@@ -97,5 +98,5 @@ private:
     GasBurner::State m_state;
     uint8_t m_ignition_counter;
     uint8_t m_dejam_counter;
-    unsigned long m_last_state_change_time{0};
+    Clock::Time m_last_state_change_time{0};
 };
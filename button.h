@@ -1,5 +1,7 @@
 #pragma once
 
+#include "clock.h"
+
 class Button {
 public:
     enum class State {
@@ -9,9 +11,9 @@ public:
     };
 
     /**
-     * Wrapper to be called from pin interrupt.
+     * Register a rising edge the pin interrupt queued at @p time.
      */
-    virtual void trigger() = 0;
+    virtual void trigger(Clock::Time time) = 0;
 
     /**
      * Updates the status of the button. Must be called repeatedly during the
@@ -31,6 +33,6 @@ class MockButton : public Button {
 public:
     // void begin() final {}
     void update() final {}
-    void trigger() final {}
+    void trigger(Clock::Time) final {}
     bool pressed() final { return false; }
 };
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Millisecond time source of all time-dependent classes.
+ *
+ * Resolved at compile time and inlined to millis() on the AVR, the host
+ * simulator backs millis() with simulated time. Timestamps are 32 bits wide
+ * on every target and wrap after 49.7 days, so compare them only through the
+ * time elapsed since, never by adding a delay to a timestamp.
+ */
+struct Clock {
+    using Time = uint32_t;
+
+    /// Current time in milliseconds.
+    static Time now() { return millis(); }
+
+    /// Milliseconds elapsed since @p start, correct across a wraparound.
+    static Time since(Time start) { return now() - start; }
+};
@@ -1,103 +1,812 @@
 #include "comm.h"
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
 #include "controller.h"
+#include "memory.h"
+#include "schedule.h"
+#include "timing.h"
+#include "trace.h"
 
 namespace {
-    enum class Command : uint8_t {
-        invalid = 0x0,
-        read_state = 0x1,
-        set_brew_temperature = 0x2,
-        set_sparging_temperature = 0x3,
-        read_burner_full_state = 0x4,
+    using protocol::Command;
+    using protocol::Field;
+    using protocol::Response;
+    namespace schema = protocol::schema;
+
+    /// Time in milliseconds the host has to confirm a new baud rate.
+    constexpr unsigned long baud_rate_confirm_timeout{2000};
+
+    /// Rates with an exact divisor at 16 MHz (and the error-prone default).
+    constexpr uint32_t baud_rates[] = {Comm::default_baud_rate, 250000, 500000, 1000000};
+
+    /**
+     * Return @c true if everything written has left the UART.
+     */
+    bool tx_idle()
+    {
+        if (Serial.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1) {
+            return false;
+        }
+
+#if defined(UCSR0A)
+        // Cleared by every HardwareSerial write, set once the shift register is empty.
+        return bit_is_set(UCSR0A, TXC0);
+#else
+        return true;
+#endif
+    }
+
+#if defined(WITH_RS485)
+    /// Bus silence in microseconds before we drive it, lets the master release DE.
+    constexpr unsigned long turnaround{2000};
+
+    /// Additional silence per address before pushing telemetry unsolicited.
+    constexpr unsigned long telemetry_slot{500};
+
+    void enable_driver()
+    {
+#if defined(UCSR0B)
+        // Keep a previous frame's completion from releasing the bus under us.
+        UCSR0B &= ~_BV(TXCIE0);
+#endif
+        digitalWrite(RS485_DE_PIN, HIGH);
+    }
+
+    /**
+     * Release the bus once the last byte handed to the UART is out.
+     */
+    void release_driver()
+    {
+#if defined(UCSR0B)
+        // Every write clears TXC0, so the interrupt fires after the stop bit of the last byte.
+        UCSR0B |= _BV(TXCIE0);
+#endif
+    }
+#endif // WITH_RS485
+
+    /// Fields supported by this build as bit mask indexed by field ID.
+    constexpr uint32_t supported_fields{(1UL << static_cast<uint8_t>(Field::brew_temperature)) | (1UL << static_cast<uint8_t>(Field::brew_target)) | (1UL << static_cast<uint8_t>(Field::sparging_temperature)) | (1UL << static_cast<uint8_t>(Field::sparging_target)) |
+#if defined(WITH_GBC)
+                                        (1UL << static_cast<uint8_t>(Field::full_burner_state)) | (1UL << static_cast<uint8_t>(Field::dejam_counter)) | (1UL << static_cast<uint8_t>(Field::ignition_counter)) |
+#endif
+#if defined(HOTPLATE_PIN)
+                                        (1UL << static_cast<uint8_t>(Field::hotplate_state)) |
+#endif
+                                        (1UL << static_cast<uint8_t>(Field::firmware_version)) | (1UL << static_cast<uint8_t>(Field::brew_schedule)) | (1UL << static_cast<uint8_t>(Field::sparging_schedule)) | (1UL << static_cast<uint8_t>(Field::uptime)) | (1UL << static_cast<uint8_t>(Field::frames_received)) | (1UL << static_cast<uint8_t>(Field::frames_rejected)) | (1UL << static_cast<uint8_t>(Field::unused_memory))};
+
+    /// Optional build features reported by read_capabilities.
+    constexpr uint16_t features{0
+#if defined(WITH_GBC)
+                                | (1 << 0)
+#endif
+#if defined(WITH_DS18B20)
+                                | (1 << 1)
+#endif
+#if defined(HOTPLATE_PIN)
+                                | (1 << 2)
+#endif
+#if defined(WITH_MOCK_CONTROLLER)
+                                | (1 << 3)
+#endif
+#if defined(WITH_SH1106) || defined(WITH_SH1107) || defined(WITH_SSD1327)
+                                | (1 << 4)
+#endif
+#if defined(WITH_KY040)
+                                | (1 << 5)
+#endif
+#if defined(WITH_BUTTONS)
+                                | (1 << 6)
+#endif
+#if defined(WITH_RS485)
+                                | (1 << 7)
+#endif
+#if defined(WITH_TRACE)
+                                | (1 << 8)
+#endif
+#if defined(WITH_TIMING)
+                                | (1 << 9)
+#endif
     };
 
-    enum class Response : uint8_t {
-        ack = 0x80,
-        nack = 0x40,
+    bool is_supported(uint8_t field) { return field < 32 && (supported_fields & (1UL << field)); }
+
+    /**
+     * Reply frame under construction, encoded into the TX buffer when done.
+     */
+    class Reply {
+    public:
+        Reply(uint8_t* tx, uint8_t& tx_size, uint8_t address, uint8_t sequence, Command command)
+        : m_tx{tx}
+        , m_tx_size{tx_size}
+        , m_buffer{address, sequence, static_cast<uint8_t>(command)}
+        {
+        }
+
+        /**
+         * Return @c true if @p size more bytes fit into the frame.
+         */
+        bool fits(uint8_t size) const { return m_size + size <= sizeof(m_buffer); }
+
+        void put(const void* data, uint8_t size)
+        {
+            memcpy(m_buffer + m_size, data, size);
+            m_size += size;
+        }
+
+        template <typename T>
+        void put(const T& value)
+        {
+            put(&value, sizeof(T));
+        }
+
+        /**
+         * Append a fixed-size message of type @p M and return its data to be filled in place.
+         */
+        template <typename M>
+        uint8_t* append()
+        {
+            static_assert(M::size <= sizeof(m_buffer) - header_size, "message does not fit into a reply");
+            uint8_t* data{m_buffer + m_size};
+            m_size += M::size;
+            return data;
+        }
+
+        /**
+         * Send reply with everything put so far.
+         */
+        void ack()
+        {
+            m_buffer[2] |= static_cast<uint8_t>(Response::ack);
+            send();
+        }
+
+        /**
+         * Send reply without any data.
+         */
+        void nack()
+        {
+            m_buffer[2] |= static_cast<uint8_t>(Response::nack);
+            m_size = header_size;
+            send();
+        }
+
+    private:
+        void send()
+        {
+            // Broadcasts are executed silently, otherwise every node would answer at once.
+            if (m_buffer[0] != frame::broadcast_address) {
+                m_tx_size = frame::encode(m_buffer, m_size, m_tx);
+            }
+        }
+
+        uint8_t* m_tx;
+        uint8_t& m_tx_size;
+        static constexpr uint8_t header_size{3};
+
+        uint8_t m_buffer[frame::max_size - 2];
+        uint8_t m_size{header_size};
     };
 
-    uint8_t response(Command command, Response response) { return static_cast<uint8_t>(command) | static_cast<uint8_t>(response); }
+    /// Shortest time between two telemetry frames in milliseconds.
+    constexpr unsigned long min_telemetry_interval{50};
+
+    int16_t centi_degrees(float temperature) { return static_cast<int16_t>(constrain(round(temperature * 100.0f), -32767.0f, 32767.0f)); }
+
+    bool exceeds(int16_t a, int16_t b, uint16_t deadband) { return abs(static_cast<long>(a) - b) >= deadband; }
+}
+
+#if defined(WITH_RS485) && defined(USART_TX_vect)
+ISR(USART_TX_vect)
+{
+    digitalWrite(RS485_DE_PIN, LOW);
+    UCSR0B &= ~_BV(TXCIE0);
 }
+#endif
 
-Comm::Comm(Controller& controller)
+Comm::Comm(Controller& controller, Schedule& brew_schedule, Schedule& sparging_schedule, uint8_t address)
 : m_controller{controller}
+, m_brew_schedule{brew_schedule}
+, m_sparging_schedule{sparging_schedule}
+, m_address{address}
+{
+}
+
+void Comm::begin()
+{
+#if defined(WITH_RS485)
+    digitalWrite(RS485_DE_PIN, LOW);
+    pinMode(RS485_DE_PIN, OUTPUT);
+#endif
+
+    Serial.begin(default_baud_rate, SERIAL_8N1);
+}
+
+Schedule* Comm::schedule(uint8_t channel)
 {
+    switch (Controller::Channel(channel)) {
+        case Controller::Channel::brew:
+            return &m_brew_schedule;
+        case Controller::Channel::sparging:
+            return &m_sparging_schedule;
+    }
+
+    return nullptr;
 }
 
 void Comm::process_serial_data()
 {
-    Command command{Command::invalid};
+    if (!update_baud_rate()) {
+        return;
+    }
+
+    // Back-pressure: no new request is consumed before the previous reply is
+    // handed to the UART. Requests of a host polling faster than the link
+    // drains queue up in the RX ring buffer; once that overflows the host
+    // gets NACKs for the resulting corrupt frames.
+    if (!send_pending()) {
+        return;
+    }
+
+    // Never wait for missing bytes, whatever is incomplete stays in the decoder.
+    while (Serial.available() > 0) {
+        m_last_rx = micros();
+
+        switch (m_decoder.feed(Serial.read())) {
+            case frame::Decoder::Result::frame:
+                // Any valid frame at the new rate confirms it.
+                m_baud_state = BaudState::normal;
+                handle_frame(m_decoder.data(), m_decoder.size());
+                break;
+            case frame::Decoder::Result::error:
+                m_frames_rejected++;
+#if !defined(WITH_RS485)
+                // The sequence number cannot be trusted, so reply with a bare NACK.
+                Reply{m_tx, m_tx_size, m_address, 0, Command::invalid}.nack();
+#endif
+                break;
+            case frame::Decoder::Result::none:
+                continue;
+        }
+
+        if (!send_pending()) {
+            return;
+        }
+    }
+
+    send_telemetry();
+    send_trace();
+}
+
+bool Comm::may_push() const
+{
+#if defined(WITH_RS485)
+    // Listen before talk, nodes with lower addresses get the bus first.
+    return Serial.available() == 0 && micros() - m_last_rx >= turnaround + m_address * telemetry_slot;
+#else
+    return true;
+#endif
+}
+
+void Comm::send_telemetry()
+{
+    if (m_telemetry_period == 0) {
+        return;
+    }
+
+    const auto now{Clock::now()};
+
+    if (now - m_last_telemetry < min_telemetry_interval) {
+        return;
+    }
+
+    if (!may_push()) {
+        return;
+    }
+
+    protocol::Telemetry current;
+    current.brew = m_controller.brew_is_connected() ? centi_degrees(m_controller.brew_temperature()) : protocol::disconnected;
+    current.brew_target = centi_degrees(m_controller.brew_target_temperature());
+    current.sparging = m_controller.sparging_is_connected() ? centi_degrees(m_controller.sparging_temperature()) : protocol::disconnected;
+    current.sparging_target = centi_degrees(m_controller.sparging_target_temperature());
+    current.full_burner_state = m_controller.full_burner_state();
+    current.flags = m_controller.sparging_heater_is_on() ? 0x1 : 0x0;
+
+    // Disconnects, target and state changes are pushed right away, temperatures beyond the deadband.
+    const bool changed{current.brew_target != m_telemetry.brew_target || current.sparging_target != m_telemetry.sparging_target || current.full_burner_state != m_telemetry.full_burner_state || current.flags != m_telemetry.flags || (current.brew == protocol::disconnected) != (m_telemetry.brew == protocol::disconnected) || (current.sparging == protocol::disconnected) != (m_telemetry.sparging == protocol::disconnected)};
+    const bool moved{m_telemetry_deadband > 0 && (exceeds(current.brew, m_telemetry.brew, m_telemetry_deadband) || exceeds(current.sparging, m_telemetry.sparging, m_telemetry_deadband))};
+
+    if (!changed && !moved && now - m_last_telemetry < m_telemetry_period) {
+        return;
+    }
+
+    Reply reply{m_tx, m_tx_size, m_address, m_telemetry_sequence++, Command::telemetry};
+    schema::TelemetryPush::store(reply.append<schema::TelemetryPush>(), current);
+    reply.ack();
+
+    m_telemetry = current;
+    m_last_telemetry = now;
+    send_pending();
+}
+
+void Comm::send_trace()
+{
+#if defined(WITH_TRACE)
+    // Only an otherwise idle link carries trace records.
+    if (!m_trace_enabled || m_tx_size > 0 || Serial.available() > 0 || !may_push()) {
+        return;
+    }
+
+    using M = schema::TraceRecord;
+    Reply reply{m_tx, m_tx_size, m_address, m_trace_sequence, Command::trace};
+    trace::Record record;
+    uint8_t count{0};
+
+    while (reply.fits(M::size) && trace::pop(record)) {
+        uint8_t* data{reply.append<M>()};
+        M::event::store(data, static_cast<uint8_t>(record.event));
+        M::time::store(data, record.time);
+        M::a::store(data, record.a);
+        M::b::store(data, record.b);
+        count++;
+    }
+
+    if (count > 0) {
+        m_trace_sequence++;
+        reply.ack();
+        send_pending();
+    }
+#endif
+}
+
+bool Comm::update_baud_rate()
+{
+    switch (m_baud_state) {
+        case BaudState::normal:
+            break;
+        case BaudState::switching:
+            // Wait until the ACK is out at the old rate.
+            if (!send_pending() || !tx_idle()) {
+                return false;
+            }
+
+            Serial.end();
+            Serial.begin(m_baud_rate, SERIAL_8N1);
+            m_baud_state = BaudState::confirming;
+            m_baud_rate_switch = Clock::now();
+            break;
+        case BaudState::confirming:
+            if (Clock::since(m_baud_rate_switch) > baud_rate_confirm_timeout) {
+                m_baud_rate = default_baud_rate;
+                Serial.end();
+                Serial.begin(m_baud_rate, SERIAL_8N1);
+                m_baud_state = BaudState::normal;
+            }
+            break;
+    }
+
+    return true;
+}
+
+bool Comm::send_pending()
+{
+    if (m_tx_sent == m_tx_size) {
+        return true;
+    }
+
+#if defined(WITH_RS485)
+    if (m_tx_sent == 0) {
+        if (micros() - m_last_rx < turnaround) {
+            return false;
+        }
+
+        enable_driver();
+    }
+#endif
+
+    // Only write what fits into the TX ring buffer, the interrupt does the rest.
+    const auto room{Serial.availableForWrite()};
+    const uint8_t count{static_cast<uint8_t>(min(room, m_tx_size - m_tx_sent))};
+
+    if (count > 0) {
+        Serial.write(m_tx + m_tx_sent, count);
+        m_tx_sent += count;
+    }
+
+    if (m_tx_sent < m_tx_size) {
+        return false;
+    }
+
+#if defined(WITH_RS485)
+    release_driver();
+#endif
+
+    m_tx_sent = 0;
+    m_tx_size = 0;
+    return true;
+}
+
+void Comm::handle_frame(const uint8_t* data, uint8_t size)
+{
+    const uint8_t address{data[0]};
+    const uint8_t sequence{data[1]};
+    const uint8_t code{data[2]};
+    const Command command{static_cast<Command>(code)};
+    const uint8_t* payload{data + 3};
+    const uint8_t payload_size{static_cast<uint8_t>(size - 3)};
 
-    if (Serial.readBytes((char*) &command, 1) != 1) {
+    // Skip frames for other nodes as well as replies, including our own echo on a bus.
+    if ((address != m_address && address != frame::broadcast_address) || (code & protocol::response_mask)) {
         return;
     }
 
+    m_frames_received++;
+
+    // Only frames addressed to us get here, so the request address is ours or broadcast.
+    Reply reply{m_tx, m_tx_size, address, sequence, command};
+
     switch (command) {
         case Command::read_state: {
-            const float brew_current{m_controller.brew_temperature()};
-            const float brew_target{m_controller.brew_target_temperature()};
-            const float sparging_current{m_controller.sparging_temperature()};
-            const float sparging_target{m_controller.sparging_target_temperature()};
+            using M = schema::ReadStateReply;
+            uint8_t* data{reply.append<M>()};
             uint8_t state{(uint8_t) m_controller.burner_state()}; // simple burner state occupies lower 6 bits
 
             if (m_controller.sparging_heater_is_on()) {
                 state |= 0x1 << 7; // simple burner state occupies lower 6 bits
             }
 
-            if (m_controller.brew_is_connected()) {
-                Serial.write((const uint8_t*) &brew_current, 4);
+            M::brew::store(data, m_controller.brew_temperature(), m_controller.brew_is_connected());
+            M::brew_target::store(data, m_controller.brew_target_temperature());
+            M::sparging::store(data, m_controller.sparging_temperature(), m_controller.sparging_is_connected());
+            M::sparging_target::store(data, m_controller.sparging_target_temperature());
+            M::state::store(data, state);
+            reply.ack();
+        } break;
+        case Command::set_brew_temperature: {
+            using M = schema::SetTemperatureRequest;
+
+            if (payload_size != M::size) {
+                reply.nack();
+                break;
             }
-            else {
-                // 0x7fffffff corresponds to IEEE 754 NaN
-                float nan;
-                unsigned long* p_nan = (unsigned long*) &nan;
-                *p_nan = 0x7fffffff;
-                Serial.write((const uint8_t*) &nan, 4);
+
+            m_controller.set_brew_temperature(M::temperature::load(payload));
+            reply.ack();
+        } break;
+        case Command::set_sparging_temperature: {
+            using M = schema::SetTemperatureRequest;
+
+            if (payload_size != M::size) {
+                reply.nack();
+                break;
+            }
+
+            m_controller.set_sparging_temperature(M::temperature::load(payload));
+            reply.ack();
+        } break;
+        case Command::read_burner_full_state: {
+            using M = schema::ReadBurnerFullStateReply;
+            M::state::store(reply.append<M>(), m_controller.full_burner_state());
+            reply.ack();
+        } break;
+        case Command::start_autotune: {
+            using M = schema::StartAutotuneRequest;
+
+            if (payload_size != M::size || M::channel::load(payload) > 1) {
+                reply.nack();
+                break;
             }
-            Serial.write((const uint8_t*) &brew_target, 4);
 
-            if (m_controller.sparging_is_connected()) {
-                Serial.write((const uint8_t*) &sparging_current, 4);
+            m_controller.start_autotune(Controller::Channel(M::channel::load(payload)), M::setpoint::load(payload)) ? reply.ack() : reply.nack();
+        } break;
+        case Command::read_autotune: {
+            using M = schema::ReadAutotuneReply;
+
+            if (payload_size != schema::ChannelRequest::size || schema::ChannelRequest::channel::load(payload) > 1) {
+                reply.nack();
+                break;
             }
-            else {
-                // 0x7fffffff corresponds to IEEE 754 NaN
-                float nan;
-                unsigned long* p_nan = (unsigned long*) &nan;
-                *p_nan = 0x7fffffff;
-                Serial.write((const uint8_t*) &nan, 4);
+
+            const auto channel{Controller::Channel(schema::ChannelRequest::channel::load(payload))};
+            const auto gains{m_controller.gains(channel)};
+            uint8_t* data{reply.append<M>()};
+            M::state::store(data, (uint8_t) m_controller.autotune_state(channel));
+            M::kp::store(data, gains.kp);
+            M::ki::store(data, gains.ki);
+            M::kd::store(data, gains.kd);
+            reply.ack();
+        } break;
+        case Command::upload_schedule: {
+            // channel, number of steps, steps
+            if (payload_size < 2 || payload[1] > Schedule::max_steps || payload_size != 2 + payload[1] * sizeof(ScheduleStep) || !schedule(payload[0])) {
+                reply.nack();
+                break;
             }
-            Serial.write((const uint8_t*) &sparging_target, 4);
 
-            Serial.write(state);
+            ScheduleStep steps[Schedule::max_steps];
+            memcpy(steps, payload + 2, payload[1] * sizeof(ScheduleStep));
+            schedule(payload[0])->set_steps(steps, payload[1]) ? reply.ack() : reply.nack();
         } break;
-        case Command::set_brew_temperature: {
-            float temperature{20.0f};
+        case Command::control_schedule: {
+            using M = schema::ControlScheduleRequest;
+            Schedule* channel_schedule{payload_size == M::size ? schedule(M::channel::load(payload)) : nullptr};
 
-            if (Serial.readBytes((char*) &temperature, 4) == 4) {
-                m_controller.set_brew_temperature(temperature);
-                Serial.write(response(Command::set_brew_temperature, Response::ack));
+            if (!channel_schedule) {
+                reply.nack();
+            }
+            else if (M::start::load(payload)) {
+                channel_schedule->start() ? reply.ack() : reply.nack();
             }
             else {
-                Serial.write(response(Command::set_brew_temperature, Response::nack));
+                channel_schedule->stop();
+                reply.ack();
             }
         } break;
-        case Command::set_sparging_temperature: {
-            float temperature{20.0f};
+        case Command::read_schedule: {
+            using M = schema::ReadScheduleReply;
+            Schedule* channel_schedule{payload_size == schema::ChannelRequest::size ? schedule(schema::ChannelRequest::channel::load(payload)) : nullptr};
 
-            if (Serial.readBytes((char*) &temperature, 4) == 4) {
-                m_controller.set_sparging_temperature(temperature);
-                Serial.write(response(Command::set_sparging_temperature, Response::ack));
+            if (!channel_schedule) {
+                reply.nack();
+                break;
             }
-            else {
-                Serial.write(response(Command::set_sparging_temperature, Response::nack));
+
+            uint8_t* data{reply.append<M>()};
+            M::phase::store(data, (uint8_t) channel_schedule->phase());
+            M::step::store(data, channel_schedule->current_step());
+            M::remaining::store(data, channel_schedule->remaining());
+            reply.ack();
+        } break;
+        case Command::subscribe: {
+            using M = schema::SubscribeRequest;
+
+            if (payload_size != M::size) {
+                reply.nack();
+                break;
             }
+
+            m_telemetry_period = M::period::load(payload);
+            m_telemetry_deadband = M::deadband::load(payload);
+
+            // Force a complete frame right after the ACK.
+            m_last_telemetry = Clock::now() - m_telemetry_period;
+            reply.ack();
         } break;
-        case Command::read_burner_full_state: {
-            const auto full_state{m_controller.full_burner_state()};
-            Serial.write((const uint8_t*) &full_state, 2);
+        case Command::batch_get: {
+            // list of field IDs, replied as [id] [length] [value] each
+            uint8_t value[8];
+
+            for (uint8_t i = 0; i < payload_size; i++) {
+                const uint8_t length{get_field(payload[i], value)};
+
+                if (!reply.fits(2 + length)) {
+                    reply.nack();
+                    return;
+                }
+
+                reply.put(payload[i]);
+                reply.put(length);
+                reply.put(value, length);
+            }
+
+            reply.ack();
         } break;
-        case Command::invalid:
+        case Command::batch_set: {
+            // list of [id] [length] [value], applied only if all of them are valid
+            for (uint8_t pass = 0; pass < 2; pass++) {
+                for (uint8_t i = 0; i < payload_size;) {
+                    if (i + 2 > payload_size || i + 2 + payload[i + 1] > payload_size || !set_field(payload[i], payload + i + 2, payload[i + 1], pass == 1)) {
+                        reply.nack();
+                        return;
+                    }
+
+                    i += 2 + payload[i + 1];
+                }
+            }
+
+            reply.ack();
+        } break;
+        case Command::read_capabilities: {
+            using M = schema::ReadCapabilitiesReply;
+            uint8_t* data{reply.append<M>()};
+            M::version::store(data, protocol::version);
+            M::fields::store(data, supported_fields);
+            M::features::store(data, features);
+            reply.put(VERSION_STRING, min(strlen(VERSION_STRING), protocol::max_version_size));
+            reply.ack();
+        } break;
+        case Command::set_baud_rate: {
+            using M = schema::SetBaudRateRequest;
+            uint32_t baud_rate{0};
+            bool valid{false};
+
+            if (payload_size == M::size) {
+                baud_rate = M::baud_rate::load(payload);
+
+                for (const auto rate : baud_rates) {
+                    valid = valid || rate == baud_rate;
+                }
+            }
+
+            if (!valid) {
+                reply.nack();
+                break;
+            }
+
+            // Switch once the ACK has been sent, then wait for the host to ping.
+            reply.ack();
+            m_baud_rate = baud_rate;
+            m_baud_state = BaudState::switching;
+        } break;
+        case Command::subscribe_trace: {
+#if defined(WITH_TRACE)
+            if (payload_size != schema::SubscribeTraceRequest::size) {
+                reply.nack();
+                break;
+            }
+
+            m_trace_enabled = schema::SubscribeTraceRequest::enable::load(payload);
+            reply.ack();
+#else
+            reply.nack();
+#endif
+        } break;
+        case Command::read_timing: {
+#if defined(WITH_TIMING)
+            using M = schema::ReadTimingRequest;
+            using R = schema::ReadTimingReply;
+            static_assert(R::buckets == timing::buckets, "histogram size differs");
+
+            if (payload_size != M::size || M::phase::load(payload) >= static_cast<uint8_t>(timing::Phase::count)) {
+                reply.nack();
+                break;
+            }
+
+            const auto phase{static_cast<timing::Phase>(M::phase::load(payload))};
+            const timing::Statistics& statistics{timing::statistics(phase)};
+            uint8_t* data{reply.append<R>()};
+            R::count::store(data, statistics.count);
+            R::min::store(data, statistics.min);
+            R::max::store(data, statistics.max);
+            R::mean::store(data, (statistics.mean + 8) >> 4);
+            reply.put(statistics.histogram);
+
+            if (M::reset::load(payload)) {
+                timing::reset(phase);
+            }
+
+            reply.ack();
+#else
+            reply.nack();
+#endif
+        } break;
+        case Command::read_memory: {
+            using M = schema::ReadMemoryRequest;
+            using R = schema::ReadMemoryReply;
+
+            if (payload_size != M::size) {
+                reply.nack();
+                break;
+            }
+
+            const memory::Usage usage{memory::usage()};
+            uint8_t* data{reply.append<R>()};
+            R::data::store(data, usage.data);
+            R::bss::store(data, usage.bss);
+            R::heap::store(data, usage.heap);
+            R::stack::store(data, usage.stack);
+            R::unused::store(data, usage.unused);
+            R::free::store(data, usage.free);
+            m_show_memory = m_show_memory || M::show::load(payload);
+            reply.ack();
+        } break;
+        case Command::ping: {
+            reply.put(payload, payload_size);
+            reply.ack();
+        } break;
+        default:
+            reply.nack();
             break;
     }
+}
+
+bool Comm::take_memory_display_request()
+{
+    const bool requested{m_show_memory};
+    m_show_memory = false;
+    return requested;
+}
+
+uint8_t Comm::get_field(uint8_t id, uint8_t* value)
+{
+    if (!is_supported(id)) {
+        return 0;
+    }
+
+    const auto put = [value](const void* data, uint8_t size) {
+        memcpy(value, data, size);
+        return size;
+    };
+
+    switch (static_cast<Field>(id)) {
+        case Field::brew_temperature: {
+            const float temperature{m_controller.brew_is_connected() ? m_controller.brew_temperature() : NAN};
+            return put(&temperature, 4);
+        }
+        case Field::brew_target: {
+            const float temperature{m_controller.brew_target_temperature()};
+            return put(&temperature, 4);
+        }
+        case Field::sparging_temperature: {
+            const float temperature{m_controller.sparging_is_connected() ? m_controller.sparging_temperature() : NAN};
+            return put(&temperature, 4);
+        }
+        case Field::sparging_target: {
+            const float temperature{m_controller.sparging_target_temperature()};
+            return put(&temperature, 4);
+        }
+        case Field::full_burner_state: {
+            const uint16_t state{m_controller.full_burner_state()};
+            return put(&state, 2);
+        }
+        case Field::hotplate_state:
+            value[0] = m_controller.sparging_heater_is_on() ? 1 : 0;
+            return 1;
+        case Field::dejam_counter:
+            value[0] = GasBurner::decode_full_state(m_controller.full_burner_state()).dejam_counter;
+            return 1;
+        case Field::ignition_counter:
+            value[0] = GasBurner::decode_full_state(m_controller.full_burner_state()).ignition_counter;
+            return 1;
+        case Field::firmware_version:
+            return put(VERSION_STRING, min(strlen(VERSION_STRING), protocol::max_version_size));
+        case Field::brew_schedule:
+        case Field::sparging_schedule: {
+            Schedule* channel_schedule{schedule(id == static_cast<uint8_t>(Field::brew_schedule) ? 0 : 1)};
+            const uint32_t remaining{channel_schedule->remaining()};
+            value[0] = static_cast<uint8_t>(channel_schedule->phase());
+            value[1] = channel_schedule->current_step();
+            memcpy(value + 2, &remaining, 4);
+            return 6;
+        }
+        case Field::uptime: {
+            const uint32_t uptime{Clock::now()};
+            return put(&uptime, 4);
+        }
+        case Field::frames_received:
+            return put(&m_frames_received, 2);
+        case Field::frames_rejected:
+            return put(&m_frames_rejected, 2);
+        case Field::unused_memory: {
+            const uint16_t unused{memory::usage().unused};
+            return put(&unused, 2);
+        }
+    }
+
+    return 0;
+}
+
+bool Comm::set_field(uint8_t id, const uint8_t* value, uint8_t size, bool apply)
+{
+    if (!is_supported(id)) {
+        return false;
+    }
+
+    float temperature;
+
+    switch (static_cast<Field>(id)) {
+        case Field::brew_target:
+        case Field::sparging_target:
+            if (size != sizeof(temperature)) {
+                return false;
+            }
 
-    Serial.flush();
+            if (apply) {
+                memcpy(&temperature, value, sizeof(temperature));
+                id == static_cast<uint8_t>(Field::brew_target) ? m_controller.set_brew_temperature(temperature) : m_controller.set_sparging_temperature(temperature);
+            }
+            return true;
+        default:
+            return false;
+    }
 }
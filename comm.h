@@ -1,12 +1,25 @@
 #pragma once
 
+#include "clock.h"
+#include "frame.h"
+#include "protocol.h"
 #include <Arduino.h>
 
 class Controller;
+class Schedule;
 
 /**
  * Brewslave communication protocol parser/handler.
  *
+ * Commands arrive in COBS frames with address, sequence number and CRC (see
+ * frame.h). Every frame for our address is answered with the same sequence
+ * number and the command code or'ed with ACK (0x80) or NACK (0x40), corrupt
+ * frames with a bare NACK. Broadcast frames are executed without reply.
+ *
+ * With WITH_RS485 the node shares a half-duplex bus: it drives RS485_DE_PIN
+ * only while sending, answers after a turnaround gap, never NACKs corrupt
+ * frames and staggers unsolicited telemetry by address.
+ *
  * It takes a controller used to set the target temperatures, read the current
  * temperatures, and read the state of heaters.
  *
@@ -15,13 +28,111 @@ class Controller;
  */
 class Comm {
 public:
-    Comm(Controller& control);
+    /// Baud rate after power-up and after a failed rate switch.
+    static constexpr uint32_t default_baud_rate{115200};
+
+    /// Node address used unless configured otherwise.
+    static constexpr uint8_t default_address{1};
+
+    Comm(Controller& control, Schedule& brew_schedule, Schedule& sparging_schedule, uint8_t address = default_address);
+
+    /**
+     * Open the serial port and release the bus.
+     */
+    void begin();
 
     /**
-     * Call on serialEvent() to trigger serial processing.
+     * Send pending replies and process received bytes without blocking. Call
+     * as often as possible.
      */
     void process_serial_data();
 
+    /**
+     * Return @c true once after a read_memory asked to show the usage.
+     */
+    bool take_memory_display_request();
+
 private:
+    enum class BaudState : uint8_t {
+        normal,
+        /// New rate acknowledged, waiting for the ACK to leave the UART.
+        switching,
+        /// New rate active, waiting for the first valid frame.
+        confirming,
+    };
+
+    void handle_frame(const uint8_t* data, uint8_t size);
+
+    /**
+     * Advance a baud rate switch.
+     *
+     * @return @c false if serial data must not be processed yet.
+     */
+    bool update_baud_rate();
+
+    /**
+     * Write value of batch field @p id to @p value (at least 8 bytes).
+     *
+     * @return Size of the value, 0 if the field is not supported.
+     */
+    uint8_t get_field(uint8_t id, uint8_t* value);
+
+    /**
+     * Validate and, if @p apply is set, write batch field @p id.
+     *
+     * @return @c false if the field is not writable or @p size is wrong.
+     */
+    bool set_field(uint8_t id, const uint8_t* value, uint8_t size, bool apply);
+
+    /**
+     * Push a telemetry frame if subscribed and due.
+     */
+    void send_telemetry();
+
+    /**
+     * Push pending trace records if enabled and the link is idle.
+     */
+    void send_trace();
+
+    /**
+     * Return @c true if an unsolicited frame may be sent now.
+     */
+    bool may_push() const;
+
+    /**
+     * Move as much of the pending reply into the UART buffer as fits.
+     *
+     * @return @c true if nothing is pending anymore.
+     */
+    bool send_pending();
+
+    /**
+     * Get schedule of @p channel or @c nullptr if invalid.
+     */
+    Schedule* schedule(uint8_t channel);
+
     Controller& m_controller;
+    Schedule& m_brew_schedule;
+    Schedule& m_sparging_schedule;
+    const uint8_t m_address;
+    frame::Decoder m_decoder{};
+    uint8_t m_tx[frame::max_encoded_size];
+    uint8_t m_tx_size{0};
+    uint8_t m_tx_sent{0};
+    BaudState m_baud_state{BaudState::normal};
+    uint32_t m_baud_rate{default_baud_rate};
+    Clock::Time m_baud_rate_switch{0};
+    uint16_t m_frames_received{0};
+    uint16_t m_frames_rejected{0};
+    /// Time of the last received byte in microseconds.
+    unsigned long m_last_rx{0};
+
+    protocol::Telemetry m_telemetry{};
+    uint16_t m_telemetry_period{0};
+    uint16_t m_telemetry_deadband{0};
+    Clock::Time m_last_telemetry{0};
+    uint8_t m_telemetry_sequence{0};
+    bool m_trace_enabled{false};
+    uint8_t m_trace_sequence{0};
+    bool m_show_memory{false};
 };
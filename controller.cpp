@@ -1,37 +1,88 @@
 #include "controller.h"
+#include "settings.h"
 #include <Arduino.h>
 
+namespace {
+    /// Interval in milliseconds over which temperature slopes are sampled.
+    constexpr unsigned long slope_interval{10000};
+    /// Upper bound of a learned dead time in seconds.
+    constexpr float max_dead_time{120.0f};
+    /// Maximum time in milliseconds to wait for the peak after stopping.
+    constexpr unsigned long max_coast_duration{300000};
+    /// Drop from the peak in degree Celsius that ends coasting.
+    constexpr float coast_peak_drop{0.5f};
+    /// Heating slope in degree Celsius per second below which coasting is not learned.
+    constexpr float min_slope{0.001f};
+    /// Time proportioning window of the burner in milliseconds, long compared to the dead time.
+    constexpr unsigned long burner_pid_window{300000};
+    /// Shortest burner on or off period in milliseconds within a window.
+    constexpr unsigned long burner_pid_min_switch{60000};
+    /// Time proportioning window of the hotplate in milliseconds.
+    constexpr unsigned long hotplate_pid_window{20000};
+    /// Shortest hotplate on or off period in milliseconds within a window.
+    constexpr unsigned long hotplate_pid_min_switch{2000};
+
+    float smooth(float average, float sample) { return 0.75f * average + 0.25f * sample; }
+}
+
 MainController::MainController(TemperatureSensor& brew_sensor, TemperatureSensor& sparging_sensor, GasBurner& burner, Hotplate& hotplate)
 : m_brew_sensor{brew_sensor}
 , m_sparging_sensor{sparging_sensor}
 , m_burner{burner}
 , m_hotplate{hotplate}
+, m_brew_pid{burner_pid_window, burner_pid_min_switch}
+, m_sparging_pid{hotplate_pid_window, hotplate_pid_min_switch}
 {
+    Gains gains;
+
+    if (settings::load_gains(static_cast<uint8_t>(Channel::brew), gains)) {
+        m_brew_pid.set_gains(gains);
+    }
+
+    if (settings::load_gains(static_cast<uint8_t>(Channel::sparging), gains)) {
+        m_sparging_pid.set_gains(gains);
+    }
 }
 
-void MainController::update(unsigned long)
+void MainController::update(unsigned long elapsed)
 {
+    m_time += elapsed;
+
     /**
-     * Brew burner flip-flop control
+     * Brew burner control
      */
-    m_burner.update();
-
     const auto brew_temperature{m_brew_sensor.temperature()};
     const auto burner_state{m_burner.state()};
 
-    if (!(m_brew_target_temperature == 0.0f)) { // act only if not in manual mode
+    learn_brew_dynamics(brew_temperature, burner_state);
+
+    if (is_autotuning(Channel::brew)) {
+        update_autotune(brew_temperature, m_brew_sensor.is_connected());
+    }
+    else if (!(m_brew_target_temperature == 0.0f)) { // act only if not in manual mode
         // safety feature: deactivate burner if temperature sensor not connected but target temperature set
         // TODO: we might wanna set a different (longer) timeout than for automatic sensor reconnects?
         if (!m_brew_sensor.is_connected() && m_brew_target_temperature != 0.0f) {
             m_burner.stop();
         }
-        // TODO: We might want to check if the +-1 deg Celsius is okay here
-        // TODO: maybe we want to limit switching frequency
-        else if ((brew_temperature < m_brew_target_temperature - 1.0f) && (burner_state == GasBurner::State::idle)) {
-            m_burner.start();
-        }
-        else if ((brew_temperature >= m_brew_target_temperature + 1.0f) && (burner_state != GasBurner::State::idle)) {
-            m_burner.stop();
+        else {
+            switch (m_brew_mode) {
+                case Mode::hysteresis:
+                    update_brew_hysteresis(brew_temperature, burner_state);
+                    break;
+                case Mode::predictive:
+                    update_brew_predictive(brew_temperature, burner_state);
+                    break;
+                case Mode::pid:
+                    // Without tuned gains the PID output stays 0, so keep heating by hysteresis.
+                    if (m_brew_pid.has_gains()) {
+                        set_heater(Channel::brew, m_brew_pid.update(m_brew_target_temperature, brew_temperature, m_time));
+                    }
+                    else {
+                        update_brew_hysteresis(brew_temperature, burner_state);
+                    }
+                    break;
+            }
         }
     }
 
@@ -41,30 +92,249 @@ void MainController::update(unsigned long)
 
     const auto sparging_temperature{m_sparging_sensor.temperature()};
 
-    if (!(m_sparging_target_temperature == 0.0f)) { // act only if not in manual mode
+    if (is_autotuning(Channel::sparging)) {
+        update_autotune(sparging_temperature, m_sparging_sensor.is_connected());
+    }
+    else if (!(m_sparging_target_temperature == 0.0f)) { // act only if not in manual mode
         // safety feature: deactivate hotplate if temperature sensor not connected but target temperature set
         // TODO: we might wanna set a different (longer) timeout than for automatic sensor reconnects?
         if (!m_sparging_sensor.is_connected() && m_sparging_target_temperature != 0.0f) {
             m_hotplate.stop();
         }
+        else if (m_sparging_mode == Mode::pid && m_sparging_pid.has_gains()) {
+            set_heater(Channel::sparging, m_sparging_pid.update(m_sparging_target_temperature, sparging_temperature, m_time));
+        }
         // TODO: We might want to check if the +-1 deg Celsius is okay here
         // TODO: maybe we want to limit switching frequency
-        else if (sparging_temperature < m_sparging_target_temperature - 1.0f) {
+        else if (sparging_temperature < m_sparging_target_temperature - m_parameters.hysteresis) {
             m_hotplate.start();
         }
-        else if (sparging_temperature >= m_sparging_target_temperature + 1.0f) {
+        else if (sparging_temperature >= m_sparging_target_temperature + m_parameters.hysteresis) {
             m_hotplate.stop();
         }
     }
 }
 
+void MainController::learn_brew_dynamics(float temperature, GasBurner::State state)
+{
+    const bool was_on{m_last_burner_state != GasBurner::State::idle};
+    const bool is_on{state != GasBurner::State::idle};
+
+    if (!was_on && is_on) {
+        m_brew_switch_time = m_time;
+        m_brew_switched = true;
+        m_measuring_dead_time = true;
+        m_coasting = false;
+    }
+    else if (was_on && !is_on) {
+        m_brew_switch_time = m_time;
+        m_brew_switched = true;
+        m_measuring_dead_time = false;
+
+        // Only a stop out of a running burner coasts.
+        if (m_last_burner_state == GasBurner::State::running) {
+            m_coasting = true;
+            m_coast_start = m_time;
+            m_coast_start_temperature = temperature;
+            m_coast_peak_temperature = temperature;
+            m_coast_start_slope = m_heating_slope;
+        }
+    }
+
+    if (m_measuring_dead_time && state == GasBurner::State::running) {
+        // Includes start delay, ignition and any dejamming in between.
+        const float dead_time{(m_time - m_brew_switch_time) / 1000.0f};
+        m_dead_time = smooth(m_dead_time, min(dead_time, max_dead_time));
+        m_measuring_dead_time = false;
+    }
+
+    m_last_burner_state = state;
+
+    if (!m_brew_sensor.is_connected()) {
+        return;
+    }
+
+    if (m_coasting) {
+        m_coast_peak_temperature = max(m_coast_peak_temperature, temperature);
+
+        const auto coast_duration{m_time - m_coast_start};
+
+        // Peak is over once the temperature drops noticeably or too much time passed.
+        if (temperature < m_coast_peak_temperature - coast_peak_drop || coast_duration > max_coast_duration) {
+            const auto overshoot{m_coast_peak_temperature - m_coast_start_temperature};
+
+            if (m_coast_start_slope > min_slope) {
+                m_coast_time = smooth(m_coast_time, min(overshoot / m_coast_start_slope, max_coast_duration / 1000.0f));
+            }
+
+            m_coasting = false;
+        }
+    }
+
+    if (m_time - m_last_slope_sample >= slope_interval) {
+        const auto slope{(temperature - m_last_slope_temperature) * 1000.0f / (m_time - m_last_slope_sample)};
+        const auto since_switch{m_time - m_brew_switch_time};
+
+        // Skip the first interval after a transition since it mixes both regimes.
+        if (m_last_slope_sample != 0 && since_switch >= slope_interval) {
+            if (state == GasBurner::State::running) {
+                m_heating_slope = smooth(m_heating_slope, slope);
+            }
+            else if (state == GasBurner::State::idle && !m_coasting) {
+                m_cooling_slope = smooth(m_cooling_slope, slope);
+            }
+        }
+
+        m_last_slope_sample = m_time;
+        m_last_slope_temperature = temperature;
+    }
+}
+
+void MainController::update_brew_hysteresis(float temperature, GasBurner::State state)
+{
+    // TODO: maybe we want to limit switching frequency
+    if ((temperature < m_brew_target_temperature - m_parameters.hysteresis) && (state == GasBurner::State::idle)) {
+        m_burner.start();
+    }
+    else if ((temperature >= m_brew_target_temperature + m_parameters.hysteresis) && (state != GasBurner::State::idle)) {
+        m_burner.stop();
+    }
+}
+
+void MainController::update_brew_predictive(float temperature, GasBurner::State state)
+{
+    const auto since_switch{m_time - m_brew_switch_time};
+
+    if (state == GasBurner::State::idle) {
+        // Temperature we will have reached by the time heat actually flows.
+        const auto predicted{temperature + min(m_cooling_slope, 0.0f) * m_dead_time};
+
+        if (predicted < m_brew_target_temperature - 0.5f * m_parameters.hysteresis && (!m_brew_switched || since_switch >= m_parameters.min_off_time * 1000UL)) {
+            m_burner.start();
+        }
+    }
+    else {
+        // Temperature the kettle will coast to if we stopped right now.
+        const auto predicted{temperature + max(m_heating_slope, 0.0f) * m_coast_time};
+
+        // Hard limit overrides the minimum on time.
+        if (temperature >= m_brew_target_temperature + m_parameters.hysteresis) {
+            m_burner.stop();
+        }
+        else if (predicted >= m_brew_target_temperature && since_switch >= m_parameters.min_on_time * 1000UL) {
+            m_burner.stop();
+        }
+    }
+}
+
+void MainController::update_autotune(float temperature, bool is_connected)
+{
+    if (!is_connected) {
+        m_tuner.cancel();
+        set_heater(m_tune_channel, false);
+        return;
+    }
+
+    const bool on{m_tuner.update(temperature, m_time)};
+
+    switch (m_tuner.state()) {
+        case RelayTuner::State::running:
+            set_heater(m_tune_channel, on);
+            break;
+        case RelayTuner::State::done: {
+            const auto& gains{m_tuner.gains()};
+
+            // A degenerate result would switch to a PID that never heats.
+            if (!gains.is_set()) {
+                set_heater(m_tune_channel, false);
+                break;
+            }
+
+            settings::store_gains(static_cast<uint8_t>(m_tune_channel), gains);
+
+            // Hand over to PID control at the tuning setpoint.
+            switch (m_tune_channel) {
+                case Channel::brew:
+                    m_brew_pid.set_gains(gains);
+                    m_brew_mode = Mode::pid;
+                    m_brew_target_temperature = m_tune_setpoint;
+                    break;
+                case Channel::sparging:
+                    m_sparging_pid.set_gains(gains);
+                    m_sparging_mode = Mode::pid;
+                    m_sparging_target_temperature = m_tune_setpoint;
+                    break;
+            }
+        } break;
+        case RelayTuner::State::idle:
+        case RelayTuner::State::failed:
+            set_heater(m_tune_channel, false);
+            break;
+    }
+}
+
+void MainController::set_heater(Channel channel, bool on)
+{
+    switch (channel) {
+        case Channel::brew: {
+            const auto state{m_burner.state()};
+
+            if (on && state == GasBurner::State::idle) {
+                m_burner.start();
+            }
+            else if (!on && state != GasBurner::State::idle) {
+                m_burner.stop();
+            }
+        } break;
+        case Channel::sparging:
+            on ? m_hotplate.start() : m_hotplate.stop();
+            break;
+    }
+}
+
+bool MainController::is_autotuning(Channel channel) const
+{
+    return m_tune_channel == channel && m_tuner.state() == RelayTuner::State::running;
+}
+
+void MainController::set_brew_mode(Mode mode)
+{
+    m_brew_mode = mode;
+}
+
+void MainController::set_sparging_mode(Mode mode)
+{
+    m_sparging_mode = mode;
+}
+
+void MainController::set_parameters(const Parameters& parameters)
+{
+    m_parameters = parameters;
+}
+
 void MainController::set_brew_temperature(float temperature)
 {
+    if (is_autotuning(Channel::brew)) {
+        m_tuner.cancel();
+    }
+
+    if (temperature == 0.0f) {
+        m_brew_pid.reset();
+    }
+
     m_brew_target_temperature = temperature;
 }
 
 void MainController::set_sparging_temperature(float temperature)
 {
+    if (is_autotuning(Channel::sparging)) {
+        m_tuner.cancel();
+    }
+
+    if (temperature == 0.0f) {
+        m_sparging_pid.reset();
+    }
+
     m_sparging_target_temperature = temperature;
 }
 
@@ -128,6 +398,31 @@ uint16_t MainController::full_burner_state()
     return m_burner.full_state();
 }
 
+bool MainController::start_autotune(Channel channel, float setpoint)
+{
+    const bool is_connected{channel == Channel::brew ? m_brew_sensor.is_connected() : m_sparging_sensor.is_connected()};
+
+    // Only one experiment at a time.
+    if (!is_connected || m_tuner.state() == RelayTuner::State::running) {
+        return false;
+    }
+
+    m_tune_channel = channel;
+    m_tune_setpoint = setpoint;
+    m_tuner.start(setpoint, m_time);
+    return true;
+}
+
+RelayTuner::State MainController::autotune_state(Channel channel)
+{
+    return m_tune_channel == channel ? m_tuner.state() : RelayTuner::State::idle;
+}
+
+Gains MainController::gains(Channel channel)
+{
+    return channel == Channel::brew ? m_brew_pid.gains() : m_sparging_pid.gains();
+}
+
 MockController::MockController() {}
 
 void MockController::update(unsigned long elapsed)
@@ -219,4 +514,19 @@ GasBurner::State MockController::burner_state()
 uint16_t MockController::full_burner_state()
 {
     return 0;
+}
+
+bool MockController::start_autotune(Channel, float)
+{
+    return false;
+}
+
+RelayTuner::State MockController::autotune_state(Channel)
+{
+    return RelayTuner::State::idle;
+}
+
+Gains MockController::gains(Channel)
+{
+    return Gains{};
 }
\ No newline at end of file
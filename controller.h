@@ -1,7 +1,9 @@
 #pragma once
 
+#include "autotune.h"
 #include "burner.h"
 #include "hotplate.h"
+#include "pid.h"
 #include "sensor.h"
 #include <Arduino.h>
 
@@ -13,6 +15,14 @@
  */
 class Controller {
 public:
+    /**
+     * Heating channels.
+     */
+    enum class Channel : uint8_t {
+        brew = 0,
+        sparging = 1,
+    };
+
     /**
      * Update internal state and potential set variables.
      *
@@ -104,16 +114,83 @@ public:
      * Expose full burner state.
      */
     virtual uint16_t full_burner_state() = 0;
+
+    /**
+     * Start relay auto-tuning of @p channel around @p setpoint.
+     *
+     * On success the derived gains are stored in EEPROM and the channel
+     * switches to PID control at @p setpoint.
+     *
+     * @return @c false if auto-tuning could not be started.
+     */
+    virtual bool start_autotune(Channel channel, float setpoint) = 0;
+
+    /**
+     * Get auto-tuning state of @p channel.
+     */
+    virtual RelayTuner::State autotune_state(Channel channel) = 0;
+
+    /**
+     * Get PID gains of @p channel.
+     */
+    virtual Gains gains(Channel channel) = 0;
 };
 
 /**
  * Our main controller that tries to reach a set target temperature based on
  * temperature readings and a gas burner controll.
+ *
+ * Sensors and burner are not polled here but expected to be updated by their
+ * own tasks.
  */
 class MainController : public Controller {
 public:
+    /**
+     * Brew burner control strategy.
+     */
+    enum class Mode : uint8_t {
+        /// Start burner below and stop it above the target temperature band.
+        hysteresis = 0,
+        /// Start and stop burner ahead of time based on learned dead time,
+        /// temperature slopes and coasting overshoot.
+        predictive = 1,
+        /// Time-proportioned PID control with (auto-tuned) gains, hysteresis
+        /// until gains are stored.
+        pid = 2,
+    };
+
+    /**
+     * Tunable control loop parameters.
+     */
+    struct Parameters {
+        /// Half-width of the switching band around the target in degree Celsius.
+        float hysteresis{1.0f};
+        /// Minimum burner on time in seconds (predictive mode only).
+        uint16_t min_on_time{60};
+        /// Minimum burner off time in seconds (predictive mode only).
+        uint16_t min_off_time{60};
+    };
+
     MainController(TemperatureSensor& brew_sensor, TemperatureSensor& sparging_sensor, GasBurner& burner, Hotplate& hotplate);
 
+    /**
+     * Select the brew burner control strategy.
+     */
+    void set_brew_mode(Mode mode);
+
+    /**
+     * Select the sparging hotplate control strategy.
+     *
+     * Mode::predictive is not supported for the hotplate and behaves like
+     * Mode::hysteresis.
+     */
+    void set_sparging_mode(Mode mode);
+
+    /**
+     * Set control loop parameters.
+     */
+    void set_parameters(const Parameters& parameters);
+
     void update(unsigned long elapsed) final;
 
     void set_brew_temperature(float temperature) final;
@@ -142,13 +219,71 @@ public:
 
     uint16_t full_burner_state() final;
 
+    bool start_autotune(Channel channel, float setpoint) final;
+
+    RelayTuner::State autotune_state(Channel channel) final;
+
+    Gains gains(Channel channel) final;
+
 private:
+    /**
+     * Learn dead time, heating/cooling slopes and coasting overshoot of the
+     * brew kettle from burner state transitions and temperature readings.
+     */
+    void learn_brew_dynamics(float temperature, GasBurner::State state);
+
+    void update_brew_hysteresis(float temperature, GasBurner::State state);
+
+    void update_brew_predictive(float temperature, GasBurner::State state);
+
+    void update_autotune(float temperature, bool is_connected);
+
+    /**
+     * Switch heater of @p channel on or off.
+     */
+    void set_heater(Channel channel, bool on);
+
+    bool is_autotuning(Channel channel) const;
+
     TemperatureSensor& m_brew_sensor;
     TemperatureSensor& m_sparging_sensor;
     GasBurner& m_burner;
     Hotplate& m_hotplate;
     float m_brew_target_temperature{0.0f};
     float m_sparging_target_temperature{0.0f};
+    Mode m_brew_mode{Mode::hysteresis};
+    Mode m_sparging_mode{Mode::hysteresis};
+    Parameters m_parameters{};
+    Pid m_brew_pid;
+    Pid m_sparging_pid;
+    RelayTuner m_tuner{};
+    Channel m_tune_channel{Channel::brew};
+    float m_tune_setpoint{0.0f};
+
+    /// Controller time in milliseconds accumulated from update() calls.
+    unsigned long m_time{0};
+    /// Time of the last burner on/off transition.
+    unsigned long m_brew_switch_time{0};
+    /// False until the first transition, the burner has been off long enough at boot.
+    bool m_brew_switched{false};
+    GasBurner::State m_last_burner_state{GasBurner::State::idle};
+    /// True while waiting for the burner to reach the running state.
+    bool m_measuring_dead_time{false};
+    /// Learned time in seconds from burner start until heat flows.
+    float m_dead_time{24.0f};
+    /// Learned temperature slope in degree Celsius per second while running.
+    float m_heating_slope{0.0f};
+    /// Learned temperature slope in degree Celsius per second while idle.
+    float m_cooling_slope{0.0f};
+    /// Learned time in seconds the temperature keeps rising after a stop.
+    float m_coast_time{20.0f};
+    bool m_coasting{false};
+    unsigned long m_coast_start{0};
+    float m_coast_start_temperature{0.0f};
+    float m_coast_start_slope{0.0f};
+    float m_coast_peak_temperature{0.0f};
+    unsigned long m_last_slope_sample{0};
+    float m_last_slope_temperature{0.0f};
 };
 
 /**
@@ -189,6 +324,12 @@ public:
 
     uint16_t full_burner_state() final;
 
+    bool start_autotune(Channel channel, float setpoint) final;
+
+    RelayTuner::State autotune_state(Channel channel) final;
+
+    Gains gains(Channel channel) final;
+
 private:
     float m_brew_current_temperature{20.0f};
     float m_brew_target_temperature{0.0f};
@@ -0,0 +1,118 @@
+#include "frame.h"
+
+uint16_t frame::crc16(uint16_t crc, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+size_t frame::encode(const uint8_t* payload, size_t size, uint8_t* out)
+{
+    const uint16_t crc{crc16(0xFFFF, payload, size)};
+    const uint8_t trailer[2] = {static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)};
+
+    size_t code_index{0};
+    size_t length{1};
+    uint8_t code{1};
+
+    for (size_t i = 0; i < size + 2; i++) {
+        const uint8_t byte{i < size ? payload[i] : trailer[i - size]};
+
+        if (byte == 0) {
+            out[code_index] = code;
+            code_index = length++;
+            code = 1;
+        }
+        else {
+            out[length++] = byte;
+
+            if (++code == 0xFF) {
+                out[code_index] = code;
+                code_index = length++;
+                code = 1;
+            }
+        }
+    }
+
+    out[code_index] = code;
+    out[length++] = 0;
+    return length;
+}
+
+frame::Decoder::Result frame::Decoder::feed(uint8_t byte)
+{
+    if (byte == 0) {
+        // Consecutive delimiters are just idle line.
+        if (m_size == 0 && m_remaining == 0 && !m_pending_zero && !m_overflow) {
+            return Result::none;
+        }
+
+        const bool complete{m_remaining == 0 && !m_overflow && m_size >= overhead};
+        const uint8_t size{m_size};
+        reset();
+
+        if (!complete) {
+            return Result::error;
+        }
+
+        const uint16_t crc{static_cast<uint16_t>(m_buffer[size - 2] | m_buffer[size - 1] << 8)};
+
+        if (crc16(0xFFFF, m_buffer, size - 2) != crc) {
+            return Result::error;
+        }
+
+        m_frame_size = size - 2;
+        return Result::frame;
+    }
+
+    if (m_remaining == 0) {
+        // Code byte: the previous block implies a zero unless it was a full block.
+        if (m_pending_zero) {
+            if (m_size < max_size) {
+                m_buffer[m_size++] = 0;
+            }
+            else {
+                m_overflow = true;
+            }
+        }
+
+        m_remaining = byte - 1;
+        m_pending_zero = byte != 0xFF;
+        return Result::none;
+    }
+
+    if (m_size < max_size) {
+        m_buffer[m_size++] = byte;
+    }
+    else {
+        m_overflow = true;
+    }
+
+    m_remaining--;
+    return Result::none;
+}
+
+const uint8_t* frame::Decoder::data() const
+{
+    return m_buffer;
+}
+
+uint8_t frame::Decoder::size() const
+{
+    return m_frame_size;
+}
+
+void frame::Decoder::reset()
+{
+    m_size = 0;
+    m_remaining = 0;
+    m_pending_zero = false;
+    m_overflow = false;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Serial framing shared by firmware and host tools.
+ *
+ * A frame carries a payload of
+ *
+ *     [address] [sequence] [code] [data ...] [crc16 low] [crc16 high]
+ *
+ * COBS encoded and terminated by a single 0x00 byte. The CRC is
+ * CRC-16/CCITT-FALSE over address, sequence, code and data.
+ */
+namespace frame {
+    /// Maximum decoded frame size including header and CRC.
+    constexpr uint8_t max_size{64};
+
+    /// Size of address, sequence, code and CRC.
+    constexpr uint8_t overhead{5};
+
+    /// Address every node executes but never answers.
+    constexpr uint8_t broadcast_address{0xFF};
+
+    /// Maximum size of the data part.
+    constexpr uint8_t max_data_size{max_size - overhead};
+
+    /// Worst-case COBS encoded size of a frame including the delimiter.
+    constexpr uint8_t max_encoded_size{max_size + max_size / 254 + 2};
+
+    /**
+     * Update CRC-16/CCITT-FALSE @p crc with @p size bytes of @p data.
+     */
+    uint16_t crc16(uint16_t crc, const uint8_t* data, size_t size);
+
+    /**
+     * Append CRC to @p size bytes of @p payload and COBS encode it into
+     * @p out, which must hold at least max_encoded_size bytes.
+     *
+     * @return Number of bytes written including the delimiter.
+     */
+    size_t encode(const uint8_t* payload, size_t size, uint8_t* out);
+
+    /**
+     * Incremental COBS decoder verifying the CRC of complete frames.
+     */
+    class Decoder {
+    public:
+        enum class Result : uint8_t {
+            /// Frame not complete yet.
+            none,
+            /// A valid frame is available through data() and size().
+            frame,
+            /// A corrupt, truncated or oversized frame was dropped.
+            error,
+        };
+
+        /**
+         * Feed a single received byte.
+         */
+        Result feed(uint8_t byte);
+
+        /**
+         * Decoded frame without CRC, valid until the next call to feed().
+         */
+        const uint8_t* data() const;
+
+        /**
+         * Size of the decoded frame without CRC.
+         */
+        uint8_t size() const;
+
+    private:
+        void reset();
+
+        uint8_t m_buffer[max_size];
+        uint8_t m_size{0};
+        uint8_t m_frame_size{0};
+        uint8_t m_remaining{0};
+        bool m_pending_zero{false};
+        bool m_overflow{false};
+    };
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+/**
+ * Arduino core subset for building the firmware on Linux.
+ *
+ * Only what the firmware and its libraries use is provided. Pins, serial
+ * port and time are backed by the simulator in sim.h. Interrupt handlers run
+ * synchronously from the simulator when it changes an input, never in the
+ * middle of firmware code, so masking interrupts is a no-op.
+ *
+ * Time, pins, registers, EEPROM and SPI are thread-local, so every thread
+ * simulates a device of its own. Serial is process-wide.
+ */
+#include "avr/pgmspace.h"
+#include "binary.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define NOT_AN_INTERRUPT -1
+
+#define SERIAL_8N1 0x06
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+
+#define PI 3.1415926535897932384626433832795
+
+#define bit(b) (1UL << (b))
+#define _BV(b) (1 << (b))
+#define bit_is_set(sfr, b) ((sfr) & _BV(b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define ISR(vector, ...) extern "C" void vector(void)
+
+// Templates instead of the AVR core's macros so that standard headers still
+// compile. Mixed signedness is fine for the macros with constant operands.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+
+template <typename T, typename L>
+auto min(const T& a, const L& b) -> decltype(b < a ? b : a)
+{
+    return (b < a) ? b : a;
+}
+
+template <typename T, typename L>
+auto max(const T& a, const L& b) -> decltype(b < a ? b : a)
+{
+    return (a < b) ? b : a;
+}
+
+#pragma GCC diagnostic pop
+
+/// ATmega328 pin numbering: 0-7 port D, 8-13 port B, A0-A5 (14-19) port C.
+constexpr uint8_t num_digital_pins{20};
+
+constexpr uint8_t A0{14};
+constexpr uint8_t A1{15};
+constexpr uint8_t A2{16};
+constexpr uint8_t A3{17};
+constexpr uint8_t A4{18};
+constexpr uint8_t A5{19};
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+#define digitalPinToPCICR(p) (((p) >= 0 && (p) < num_digital_pins) ? (&PCICR) : nullptr)
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : (((p) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(p) (((p) <= 7) ? (&PCMSK2) : (((p) <= 13) ? (&PCMSK0) : (&PCMSK1)))
+#define digitalPinToPCMSKbit(p) (((p) <= 7) ? (p) : (((p) <= 13) ? ((p) - 8) : ((p) - 14)))
+
+#define PB 2
+#define PC 3
+#define PD 4
+
+#define digitalPinToPort(p) (((p) <= 7) ? PD : (((p) <= 13) ? PB : PC))
+#define digitalPinToBitMask(p) static_cast<uint8_t>(_BV(digitalPinToPCMSKbit(p)))
+#define portInputRegister(port) ((port) == PB ? &PINB : ((port) == PC ? &PINC : &PIND))
+
+extern thread_local volatile uint8_t SREG;
+extern thread_local volatile uint8_t PCICR;
+extern thread_local volatile uint8_t PCIFR;
+extern thread_local volatile uint8_t PCMSK0;
+extern thread_local volatile uint8_t PCMSK1;
+extern thread_local volatile uint8_t PCMSK2;
+/// Port input registers, follow the pin levels like on the AVR.
+extern thread_local volatile uint8_t PINB;
+extern thread_local volatile uint8_t PINC;
+extern thread_local volatile uint8_t PIND;
+
+/// USART0 registers of Serial, process-wide like Serial itself.
+#define TXC0 6
+#define TXCIE0 6
+#define USART_TX_vect USART_TX_vect
+
+/// TXC0 is cleared by every write and set once the PTY took all bytes.
+extern volatile uint8_t UCSR0A;
+/// With TXCIE0 set USART_TX_vect runs instead of setting TXC0.
+extern volatile uint8_t UCSR0B;
+#define UCSR0A UCSR0A
+#define UCSR0B UCSR0B
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+/**
+ * UART backed by the simulator's PTY with the AVR core's buffer sizes.
+ */
+class HardwareSerial {
+public:
+    void begin(unsigned long baud, uint8_t config = SERIAL_8N1);
+    void end();
+    int available();
+    int availableForWrite();
+    int peek();
+    int read();
+    size_t write(uint8_t value);
+    size_t write(const uint8_t* buffer, size_t size);
+    void flush();
+
+    operator bool() const { return m_baud != 0; }
+
+private:
+    unsigned long m_baud{0};
+};
+
+extern HardwareSerial Serial;
+
+void setup();
+void loop();
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * ATmega328 EEPROM in RAM, loaded and saved by the simulator.
+ */
+class EEPROMClass {
+public:
+    static constexpr uint16_t size{1024};
+
+    EEPROMClass() { memset(m_data, 0xFF, sizeof(m_data)); }
+
+    uint8_t read(int address) const { return m_data[address]; }
+
+    void write(int address, uint8_t value) { m_data[address] = value; }
+
+    void update(int address, uint8_t value) { write(address, value); }
+
+    template <typename T>
+    T& get(int address, T& value) const
+    {
+        memcpy(&value, m_data + address, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value)
+    {
+        memcpy(m_data + address, &value, sizeof(T));
+        return value;
+    }
+
+    uint16_t length() const { return size; }
+
+    uint8_t* data() { return m_data; }
+
+private:
+    uint8_t m_data[size];
+};
+
+extern thread_local EEPROMClass EEPROM;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV4 0x00
+#define SPI_CLOCK_DIV8 0x05
+#define SPI_CLOCK_DIV16 0x01
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+struct SPISettings {
+    SPISettings() = default;
+    SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+/**
+ * SPI master that discards everything, the simulator only counts bytes and
+ * hashes them to compare display output between runs.
+ */
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    void setClockDivider(uint8_t) {}
+    void setDataMode(uint8_t) {}
+    void setBitOrder(uint8_t) {}
+
+    uint8_t transfer(uint8_t data)
+    {
+        hash(data);
+        m_bytes++;
+        return 0;
+    }
+
+    void transfer(void* buffer, size_t size)
+    {
+        for (size_t i = 0; i < size; i++) {
+            hash(static_cast<uint8_t*>(buffer)[i]);
+        }
+
+        memset(buffer, 0, size);
+        m_bytes += size;
+    }
+
+    /// Number of bytes transferred since start.
+    unsigned long bytes() const { return m_bytes; }
+
+    /// FNV-1a hash of all bytes transferred since start.
+    uint32_t checksum() const { return m_checksum; }
+
+private:
+    void hash(uint8_t data) { m_checksum = (m_checksum ^ data) * 16777619u; }
+
+    unsigned long m_bytes{0};
+    uint32_t m_checksum{2166136261u};
+};
+
+extern thread_local SPIClass SPI;
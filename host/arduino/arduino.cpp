@@ -0,0 +1,435 @@
+#include "sim.h"
+#include "../link.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <SPI.h>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+thread_local volatile uint8_t SREG;
+thread_local volatile uint8_t PCICR;
+thread_local volatile uint8_t PCIFR;
+thread_local volatile uint8_t PCMSK0;
+thread_local volatile uint8_t PCMSK1;
+thread_local volatile uint8_t PCMSK2;
+thread_local volatile uint8_t PINB;
+thread_local volatile uint8_t PINC;
+thread_local volatile uint8_t PIND;
+
+volatile uint8_t UCSR0A;
+volatile uint8_t UCSR0B;
+
+HardwareSerial Serial;
+thread_local SPIClass SPI;
+thread_local EEPROMClass EEPROM;
+
+// Defined by the firmware's ISR() if it handles them.
+extern "C" void PCINT0_vect() __attribute__((weak));
+extern "C" void PCINT1_vect() __attribute__((weak));
+extern "C" void PCINT2_vect() __attribute__((weak));
+extern "C" void USART_TX_vect() __attribute__((weak));
+
+namespace {
+    using WallClock = std::chrono::steady_clock;
+
+    struct Clock {
+        WallClock::time_point start{WallClock::now()};
+        double speed{1.0};
+        /// Time accumulated before the last speed change plus advance() calls.
+        double offset{0.0};
+    };
+
+    thread_local Clock time_base;
+
+    struct Pin {
+        uint8_t mode{INPUT};
+        uint8_t output{LOW};
+        /// Level forced from outside, -1 if undriven.
+        int8_t input{-1};
+    };
+
+    thread_local Pin pins[num_digital_pins];
+
+    struct Interrupt {
+        void (*handler)(){nullptr};
+        int mode{0};
+    };
+
+    /// INT0 on pin 2 and INT1 on pin 3.
+    thread_local Interrupt external_interrupts[2];
+
+    struct Uart {
+        int fd{-1};
+        /// Slave side kept open so the PTY never hangs up between clients.
+        int slave{-1};
+        uint8_t rx[SERIAL_RX_BUFFER_SIZE];
+        uint8_t rx_head{0};
+        uint8_t rx_count{0};
+        std::vector<uint8_t> tx;
+        /// Driver enable pin, num_digital_pins if always driving.
+        uint8_t driver_enable{num_digital_pins};
+        unsigned long discarded{0};
+    } uart;
+
+    double wall_us()
+    {
+        return std::chrono::duration<double, std::micro>(WallClock::now() - time_base.start).count();
+    }
+
+    uint8_t level(uint8_t pin)
+    {
+        const Pin& p{pins[pin]};
+
+        if (p.input >= 0) {
+            return p.input;
+        }
+
+        // As on the AVR a high output latch on an input enables the pull-up,
+        // undriven inputs without it read low.
+        return p.output;
+    }
+
+    /**
+     * Mirror the level of @p pin into its port input register.
+     */
+    void update_port(uint8_t pin)
+    {
+        volatile uint8_t& port{*portInputRegister(digitalPinToPort(pin))};
+        const uint8_t mask{digitalPinToBitMask(pin)};
+
+        port = level(pin) ? port | mask : port & ~mask;
+    }
+
+    void pin_changed(uint8_t pin, uint8_t from, uint8_t to)
+    {
+        const int interrupt{digitalPinToInterrupt(pin)};
+
+        if (interrupt != NOT_AN_INTERRUPT && external_interrupts[interrupt].handler) {
+            const int mode{external_interrupts[interrupt].mode};
+
+            if (mode == CHANGE || (mode == RISING && to == HIGH) || (mode == FALLING && from == HIGH)) {
+                external_interrupts[interrupt].handler();
+            }
+        }
+
+        const uint8_t group{static_cast<uint8_t>(digitalPinToPCICRbit(pin))};
+
+        if (!(PCICR & bit(group)) || !(*digitalPinToPCMSK(pin) & bit(digitalPinToPCMSKbit(pin)))) {
+            return;
+        }
+
+        void (*const vectors[])() = {PCINT0_vect, PCINT1_vect, PCINT2_vect};
+
+        if (vectors[group]) {
+            vectors[group]();
+        }
+    }
+
+    /**
+     * Flag transmit complete, through the interrupt if enabled.
+     */
+    void transmit_complete()
+    {
+        if ((UCSR0B & bit(TXCIE0)) && USART_TX_vect) {
+            // The hardware clears TXC0 when it runs the handler.
+            UCSR0A &= ~bit(TXC0);
+            USART_TX_vect();
+        }
+        else {
+            UCSR0A |= bit(TXC0);
+        }
+    }
+
+    bool driver_enabled()
+    {
+        const uint8_t pin{uart.driver_enable};
+        return pin >= num_digital_pins || (pins[pin].mode == OUTPUT && pins[pin].output == HIGH);
+    }
+
+    void drive(uint8_t pin, int8_t input, bool interrupts = true)
+    {
+        if (pin >= num_digital_pins) {
+            return;
+        }
+
+        const uint8_t from{level(pin)};
+        pins[pin].input = input;
+        const uint8_t to{level(pin)};
+        update_port(pin);
+
+        if (interrupts && from != to) {
+            pin_changed(pin, from, to);
+        }
+    }
+}
+
+void sim::set_speed(double speed)
+{
+    // Rebase so that time is continuous across speed changes.
+    time_base.offset = static_cast<double>(now());
+    time_base.start = WallClock::now();
+    time_base.speed = speed;
+}
+
+void sim::advance(uint64_t us)
+{
+    time_base.offset += static_cast<double>(us);
+}
+
+uint64_t sim::now()
+{
+    return static_cast<uint64_t>(time_base.offset + (time_base.speed > 0 ? wall_us() * time_base.speed : 0.0));
+}
+
+void sim::reset()
+{
+    time_base = Clock{};
+
+    for (Pin& pin : pins) {
+        pin = Pin{};
+    }
+
+    for (Interrupt& interrupt : external_interrupts) {
+        interrupt = Interrupt{};
+    }
+
+    SREG = PCICR = PCIFR = PCMSK0 = PCMSK1 = PCMSK2 = 0;
+    PINB = PINC = PIND = 0;
+}
+
+void sim::set_input(uint8_t pin, uint8_t level)
+{
+    drive(pin, level ? HIGH : LOW);
+}
+
+void sim::hold_input(uint8_t pin, uint8_t level)
+{
+    drive(pin, level ? HIGH : LOW, false);
+}
+
+void sim::release_input(uint8_t pin)
+{
+    drive(pin, -1);
+}
+
+uint8_t sim::output(uint8_t pin)
+{
+    return pin < num_digital_pins ? pins[pin].output : LOW;
+}
+
+bool sim::is_output(uint8_t pin)
+{
+    return pin < num_digital_pins && pins[pin].mode == OUTPUT;
+}
+
+std::string sim::open_serial()
+{
+    std::string name;
+    uart.fd = host::open_pty(name);
+    uart.slave = ::open(name.c_str(), O_RDWR | O_NOCTTY);
+
+    if (uart.slave < 0) {
+        throw std::system_error{errno, std::generic_category(), name};
+    }
+
+    return name;
+}
+
+void sim::poll_serial(int timeout_ms)
+{
+    if (uart.fd < 0) {
+        return;
+    }
+
+    pollfd fd{uart.fd, 0, 0};
+
+    if (Serial && uart.rx_count < sizeof(uart.rx)) {
+        fd.events |= POLLIN;
+    }
+
+    if (!uart.tx.empty()) {
+        fd.events |= POLLOUT;
+    }
+
+    if (uart.tx.empty() && (UCSR0A & bit(TXC0)) && (UCSR0B & bit(TXCIE0))) {
+        // Enabling the interrupt with TXC0 already set fires it at once.
+        transmit_complete();
+    }
+
+    if (::poll(&fd, 1, timeout_ms) <= 0) {
+        return;
+    }
+
+    if (fd.revents & POLLOUT) {
+        if (!driver_enabled()) {
+            uart.discarded += uart.tx.size();
+            uart.tx.clear();
+        }
+        else {
+            const ssize_t written{::write(uart.fd, uart.tx.data(), uart.tx.size())};
+
+            if (written > 0) {
+                uart.tx.erase(uart.tx.begin(), uart.tx.begin() + written);
+            }
+        }
+
+        if (uart.tx.empty()) {
+            transmit_complete();
+        }
+    }
+
+    if (fd.revents & POLLIN) {
+        // Read into the ring in at most two contiguous pieces.
+        while (uart.rx_count < sizeof(uart.rx)) {
+            const uint8_t tail{static_cast<uint8_t>((uart.rx_head + uart.rx_count) % sizeof(uart.rx))};
+            const size_t contiguous{min(sizeof(uart.rx) - uart.rx_count, sizeof(uart.rx) - tail)};
+            const ssize_t received{::read(uart.fd, uart.rx + tail, contiguous)};
+
+            if (received <= 0) {
+                break;
+            }
+
+            uart.rx_count += received;
+        }
+    }
+}
+
+void sim::set_driver_enable(uint8_t pin)
+{
+    uart.driver_enable = pin;
+}
+
+unsigned long sim::discarded_bytes()
+{
+    return uart.discarded;
+}
+
+unsigned long millis()
+{
+    return sim::now() / 1000;
+}
+
+unsigned long micros()
+{
+    return sim::now();
+}
+
+void delay(unsigned long ms)
+{
+    sim::advance(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    sim::advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= num_digital_pins) {
+        return;
+    }
+
+    pins[pin].mode = mode;
+
+    if (mode != OUTPUT) {
+        pins[pin].output = mode == INPUT_PULLUP ? HIGH : LOW;
+    }
+
+    update_port(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < num_digital_pins) {
+        pins[pin].output = value ? HIGH : LOW;
+        update_port(pin);
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < num_digital_pins ? level(pin) : LOW;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode)
+{
+    if (interrupt < 2) {
+        external_interrupts[interrupt] = Interrupt{handler, mode};
+    }
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+    if (interrupt < 2) {
+        external_interrupts[interrupt] = Interrupt{};
+    }
+}
+
+void HardwareSerial::begin(unsigned long baud, uint8_t)
+{
+    m_baud = baud;
+}
+
+void HardwareSerial::end()
+{
+    flush();
+    m_baud = 0;
+}
+
+int HardwareSerial::available()
+{
+    return uart.rx_count;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    // The AVR core reports one byte less than its buffer size when empty.
+    return uart.tx.size() >= SERIAL_TX_BUFFER_SIZE - 1 ? 0 : SERIAL_TX_BUFFER_SIZE - 1 - uart.tx.size();
+}
+
+int HardwareSerial::peek()
+{
+    return uart.rx_count ? uart.rx[uart.rx_head] : -1;
+}
+
+int HardwareSerial::read()
+{
+    if (uart.rx_count == 0) {
+        return -1;
+    }
+
+    const uint8_t value{uart.rx[uart.rx_head]};
+    uart.rx_head = (uart.rx_head + 1) % sizeof(uart.rx);
+    uart.rx_count--;
+    return value;
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    // Blocks on the AVR when full, the PTY drains on the next poll instead.
+    uart.tx.insert(uart.tx.end(), buffer, buffer + size);
+    UCSR0A &= ~bit(TXC0);
+    return size;
+}
+
+void HardwareSerial::flush()
+{
+    while (!uart.tx.empty() && uart.fd >= 0) {
+        const size_t pending{uart.tx.size()};
+        sim::poll_serial(100);
+
+        if (uart.tx.size() == pending) {
+            break;
+        }
+    }
+}
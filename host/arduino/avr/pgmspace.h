@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * Program memory is ordinary memory on the host.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t*>(address))
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t*>(address))
+#define pgm_read_dword(address) (*reinterpret_cast<const uint32_t*>(address))
+#define pgm_read_float(address) (*reinterpret_cast<const float*>(address))
+#define pgm_read_ptr(address) (*reinterpret_cast<const void* const*>(address))
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcpy_P strcpy
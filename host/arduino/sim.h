@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * Control side of the Arduino shim, used by the simulator's main loop.
+ *
+ * Everything but the serial port acts on the calling thread's device.
+ */
+#include <cstdint>
+#include <string>
+
+namespace sim {
+    /**
+     * Let time follow the wall clock scaled by @p speed, 0 stops it so that
+     * it only moves by advance() and the firmware's delay() calls.
+     */
+    void set_speed(double speed);
+
+    /**
+     * Move time forward by @p us microseconds.
+     */
+    void advance(uint64_t us);
+
+    /// Current time in microseconds since start.
+    uint64_t now();
+
+    /**
+     * Return time, pins and interrupt registrations to their power-on state
+     * for running another scenario in the same process. Serial is kept.
+     */
+    void reset();
+
+    /**
+     * Drive @p pin from outside, runs pin change and external interrupt
+     * handlers if the level changes.
+     */
+    void set_input(uint8_t pin, uint8_t level);
+
+    /**
+     * Drive @p pin like set_input() without running interrupt handlers, for
+     * levels whose interrupts are replayed as the events they queued.
+     */
+    void hold_input(uint8_t pin, uint8_t level);
+
+    /**
+     * Stop driving @p pin, it floats or follows its pull-up again.
+     */
+    void release_input(uint8_t pin);
+
+    /// Level the firmware writes to @p pin.
+    uint8_t output(uint8_t pin);
+
+    /// @c true if the firmware configured @p pin as output.
+    bool is_output(uint8_t pin);
+
+    /**
+     * Back Serial by a new PTY and return its slave device name.
+     *
+     * @throw std::system_error if no PTY is available.
+     */
+    std::string open_serial();
+
+    /**
+     * Move bytes between the PTY and the UART buffers, waiting up to
+     * @p timeout_ms for the PTY.
+     */
+    void poll_serial(int timeout_ms);
+
+    /**
+     * Like an RS-485 transceiver only put bytes on the PTY while @p pin is a
+     * high output, others are discarded.
+     */
+    void set_driver_enable(uint8_t pin);
+
+    /// Bytes discarded because the driver was disabled when they left.
+    unsigned long discarded_bytes();
+}
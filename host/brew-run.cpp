@@ -0,0 +1,158 @@
+#include "brew-run.h"
+#include "arduino/sim.h"
+#include "settings.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+using host::BrewResult;
+using host::BrewRun;
+using host::Kettle;
+
+namespace {
+    /// Periods of gbc_task, sensor_task and control_task in app.cpp.
+    constexpr Clock::Time step{50};
+    constexpr Clock::Time sensor_period{188};
+    constexpr Clock::Time control_period{1000};
+}
+
+BrewRun::BrewRun()
+{
+    sparging_kettle.volume = 30.0f;
+    sparging_kettle.power = 2000.0f;
+    sparging_kettle.heat_lag = 60.0f;
+}
+
+BrewResult host::simulate(const BrewRun& run, std::ostream* csv)
+{
+    sim::reset();
+    sim::set_speed(0.0);
+
+    // MainController picks its gains up from EEPROM like on the device.
+    settings::store_gains(static_cast<uint8_t>(Controller::Channel::brew), run.brew_gains);
+    settings::store_gains(static_cast<uint8_t>(Controller::Channel::sparging), run.sparging_gains);
+
+    Kettle brew_kettle{run.brew_kettle};
+    Kettle sparging_kettle{run.sparging_kettle};
+    PlantSensor brew_sensor{brew_kettle, run.resolution};
+    PlantSensor sparging_sensor{sparging_kettle, run.resolution};
+    PlantBurner burner{static_cast<Clock::Time>(run.dead_time * 1000.0f)};
+    PlantHotplate hotplate;
+    MainController controller{brew_sensor, sparging_sensor, burner, hotplate};
+    BrewResult result{Metrics{run.band}, Metrics{run.band}, 0.0f, 0.0f};
+
+    if (csv) {
+        *csv << "time,brew,brew_sensor,burner,sparging,sparging_sensor,hotplate\n";
+    }
+
+    controller.set_brew_mode(run.brew_mode);
+    controller.set_sparging_mode(run.sparging_mode);
+    controller.set_parameters(run.parameters);
+
+    brew_sensor.begin();
+    sparging_sensor.begin();
+    burner.begin();
+    hotplate.begin();
+
+    controller.set_brew_temperature(run.brew_target);
+    controller.set_sparging_temperature(run.sparging_target);
+
+    for (Clock::Time now = 0; now < run.duration; now += step) {
+        burner.update();
+
+        if (now % sensor_period < step) {
+            brew_sensor.update();
+            sparging_sensor.update();
+        }
+
+        if (now % control_period == 0 && now != 0) {
+            controller.update(control_period);
+        }
+
+        brew_kettle.advance(step / 1000.0f, burner.heating());
+        sparging_kettle.advance(step / 1000.0f, hotplate.heating());
+        sim::advance(step * 1000ULL);
+
+        result.brew.update(Clock::now(), run.brew_target, brew_kettle.temperature(), burner.state() != GasBurner::State::idle);
+        result.sparging.update(Clock::now(), run.sparging_target, sparging_kettle.temperature(), hotplate.heating());
+
+        if (csv && Clock::now() % 1000 == 0) {
+            *csv << Clock::now() / 1000 << ',' << brew_kettle.temperature() << ',' << brew_sensor.temperature() << ',' << (burner.heating() ? 1 : 0) << ',' << sparging_kettle.temperature() << ',' << sparging_sensor.temperature() << ',' << (hotplate.heating() ? 1 : 0) << '\n';
+        }
+    }
+
+    result.brew_temperature = brew_kettle.temperature();
+    result.sparging_temperature = sparging_kettle.temperature();
+    return result;
+}
+
+MainController::Mode host::parse_mode(const std::string& name)
+{
+    if (name == "hysteresis") {
+        return MainController::Mode::hysteresis;
+    }
+    else if (name == "predictive") {
+        return MainController::Mode::predictive;
+    }
+    else if (name == "pid") {
+        return MainController::Mode::pid;
+    }
+
+    throw std::invalid_argument{"unknown mode " + name};
+}
+
+void host::parse_kettle(const std::string& spec, Kettle::Parameters& parameters)
+{
+    size_t start{0};
+
+    while (start < spec.size()) {
+        const size_t end{std::min(spec.find(',', start), spec.size())};
+        const std::string item{spec.substr(start, end - start)};
+        const size_t equals{item.find('=')};
+
+        if (equals == std::string::npos) {
+            throw std::invalid_argument{"expected key=value: " + item};
+        }
+
+        const std::string key{item.substr(0, equals)};
+        const float value{std::stof(item.substr(equals + 1))};
+
+        if (key == "volume") {
+            parameters.volume = value;
+        }
+        else if (key == "power") {
+            parameters.power = value;
+        }
+        else if (key == "loss") {
+            parameters.loss = value;
+        }
+        else if (key == "ambient") {
+            parameters.ambient = value;
+        }
+        else if (key == "initial") {
+            parameters.initial = value;
+        }
+        else if (key == "heat-lag") {
+            parameters.heat_lag = value;
+        }
+        else if (key == "probe-lag") {
+            parameters.probe_lag = value;
+        }
+        else {
+            throw std::invalid_argument{"unknown kettle parameter " + key};
+        }
+
+        start = end + 1;
+    }
+}
+
+Gains host::parse_gains(const std::string& spec)
+{
+    Gains gains;
+
+    if (sscanf(spec.c_str(), "%f,%f,%f", &gains.kp, &gains.ki, &gains.kd) != 3) {
+        throw std::invalid_argument{"expected kp,ki,kd: " + spec};
+    }
+
+    return gains;
+}
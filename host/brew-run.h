@@ -0,0 +1,72 @@
+#pragma once
+
+#include "controller.h"
+#include "plant.h"
+#include <ostream>
+#include <string>
+
+namespace host {
+    /**
+     * Closed-loop simulation of MainController heating a brew and a sparging
+     * kettle of the thermal plant.
+     */
+    struct BrewRun {
+        MainController::Mode brew_mode{MainController::Mode::hysteresis};
+        MainController::Mode sparging_mode{MainController::Mode::hysteresis};
+        /// Targets in degree Celsius, 0 is off.
+        float brew_target{66.0f};
+        float sparging_target{0.0f};
+        Kettle::Parameters brew_kettle{};
+        Kettle::Parameters sparging_kettle{};
+        MainController::Parameters parameters{};
+        /// PID gains stored to EEPROM before the controller is created.
+        Gains brew_gains{};
+        Gains sparging_gains{};
+        /// Seconds from burner start to running.
+        float dead_time{24.0f};
+        /// Sensor quantization in degree Celsius.
+        float resolution{0.0625f};
+        /// Half-width of the settled band in degree Celsius.
+        float band{0.5f};
+        /// Simulated milliseconds.
+        Clock::Time duration{7200000};
+
+        BrewRun();
+    };
+
+    struct BrewResult {
+        Metrics brew;
+        Metrics sparging;
+        /// Final water temperatures in degree Celsius.
+        float brew_temperature;
+        float sparging_temperature;
+    };
+
+    /**
+     * Run @p run on the calling thread's simulated device, optionally writing
+     * the trajectory to @p csv once per simulated second.
+     */
+    BrewResult simulate(const BrewRun& run, std::ostream* csv = nullptr);
+
+    /**
+     * Parse "hysteresis", "predictive" or "pid".
+     *
+     * @throw std::invalid_argument for anything else.
+     */
+    MainController::Mode parse_mode(const std::string& name);
+
+    /**
+     * Parse "key=value,..." with volume, power, loss, ambient, initial,
+     * heat-lag and probe-lag into @p parameters.
+     *
+     * @throw std::invalid_argument for unknown keys or missing values.
+     */
+    void parse_kettle(const std::string& spec, Kettle::Parameters& parameters);
+
+    /**
+     * Parse "kp,ki,kd".
+     *
+     * @throw std::invalid_argument if not three numbers.
+     */
+    Gains parse_gains(const std::string& spec);
+}
@@ -0,0 +1,315 @@
+/**
+ * Half-duplex RS-485 bus emulator: runs several brewslave-rs485 nodes with
+ * distinct addresses and connects them and one host PTY to a shared wire.
+ *
+ * The wire carries one byte per character time at the given baud rate. A
+ * party drives it while it has bytes queued; each byte reaches every other
+ * party. If several drive at once the byte is a collision: receivers get the
+ * wired AND of all bytes, which garbles the frames, and the collision is
+ * counted against every sender. Nodes only hand bytes to the wire while they
+ * assert DE, bytes written with DE low are counted by the node itself.
+ */
+#include "link.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        unsigned nodes{3};
+        uint32_t baud_rate{115200};
+        std::string slave;
+        /// Passed on to every node, e.g. --fault.
+        std::vector<std::string> arguments;
+    };
+
+    struct Party {
+        std::string name;
+        int fd{-1};
+        pid_t pid{-1};
+        /// Bytes waiting for the wire.
+        std::deque<uint8_t> queue;
+        unsigned long sent{0};
+        unsigned long collisions{0};
+        /// Bytes dropped because the party did not read them in time.
+        unsigned long overruns{0};
+    };
+
+    volatile std::sig_atomic_t running{1};
+
+    void stop(int) { running = 0; }
+
+    std::system_error os_error(const std::string& what)
+    {
+        return std::system_error{errno, std::generic_category(), what};
+    }
+
+    /**
+     * Start node @p address and return it with its PTY opened.
+     */
+    Party spawn(const Options& options, unsigned address)
+    {
+        int output[2];
+
+        if (::pipe2(output, O_CLOEXEC) < 0) {
+            throw os_error("pipe");
+        }
+
+        const pid_t pid{::fork()};
+
+        if (pid < 0) {
+            throw os_error("fork");
+        }
+
+        if (pid == 0) {
+            // Only brewbus gets the terminal's SIGINT and stops the nodes itself.
+            ::setpgid(0, 0);
+            ::dup2(output[1], STDOUT_FILENO);
+            ::setenv("BREWSLAVE_ADDRESS", std::to_string(address).c_str(), 1);
+
+            std::vector<char*> argv{const_cast<char*>(options.slave.c_str())};
+
+            for (const std::string& argument : options.arguments) {
+                argv.push_back(const_cast<char*>(argument.c_str()));
+            }
+
+            argv.push_back(nullptr);
+            ::execv(argv[0], argv.data());
+            perror(argv[0]);
+            _exit(127);
+        }
+
+        ::close(output[1]);
+
+        // The node prints its PTY name first.
+        std::string name;
+
+        for (char c; ::read(output[0], &c, 1) == 1 && c != '\n';) {
+            name += c;
+        }
+
+        ::close(output[0]);
+
+        Party node;
+        node.name = "node " + std::to_string(address);
+        node.pid = pid;
+
+        if (name.empty()) {
+            throw std::runtime_error{"cannot start " + options.slave};
+        }
+
+        node.fd = host::open_serial(name, 115200);
+        return node;
+    }
+
+    /**
+     * Write @p value to @p party, a full PTY drops it like a UART overrun.
+     */
+    void deliver(Party& party, uint8_t value)
+    {
+        if (::write(party.fd, &value, 1) != 1) {
+            party.overruns++;
+        }
+    }
+
+    /**
+     * Put one character time on the wire.
+     */
+    void transfer(std::vector<Party>& parties)
+    {
+        uint8_t value{0xFF};
+        unsigned senders{0};
+
+        for (Party& party : parties) {
+            if (!party.queue.empty()) {
+                value &= party.queue.front();
+                senders++;
+            }
+        }
+
+        if (senders == 0) {
+            return;
+        }
+
+        for (Party& party : parties) {
+            if (party.queue.empty()) {
+                deliver(party, value);
+                continue;
+            }
+
+            // The transceiver's receiver is disabled while it drives.
+            party.queue.pop_front();
+            party.sent++;
+
+            if (senders > 1) {
+                party.collisions++;
+            }
+        }
+    }
+
+    /**
+     * Read what @p party sent onto its queue.
+     *
+     * @return @c false if it is gone.
+     */
+    bool receive(Party& party)
+    {
+        uint8_t buffer[256];
+
+        for (;;) {
+            const ssize_t received{::read(party.fd, buffer, sizeof(buffer))};
+
+            if (received > 0) {
+                party.queue.insert(party.queue.end(), buffer, buffer + received);
+            }
+            else if (received < 0 && errno == EAGAIN) {
+                return true;
+            }
+            else {
+                return false;
+            }
+        }
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] [-- node options]\n"
+                "  -n, --nodes N         number of nodes, addresses 1 to N (default 3)\n"
+                "  -b, --baud RATE       bus baud rate (default 115200)\n"
+                "  -x, --slave PATH      node binary (default brewslave-rs485 next to %s)\n"
+                "Node options, e.g. --fault no-gas, are passed to every node.\n",
+                name, name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    const std::string self{argv[0]};
+    const auto slash{self.rfind('/')};
+    options.slave = (slash == std::string::npos ? std::string{"."} : self.substr(0, slash)) + "/brewslave-rs485";
+
+    const option long_options[] = {
+        {"nodes", required_argument, nullptr, 'n'},
+        {"baud", required_argument, nullptr, 'b'},
+        {"slave", required_argument, nullptr, 'x'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "n:b:x:h", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 'n':
+                options.nodes = std::stoul(optarg);
+                break;
+            case 'b':
+                options.baud_rate = std::stoul(optarg);
+                break;
+            case 'x':
+                options.slave = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    options.arguments.assign(argv + optind, argv + argc);
+
+    if (options.nodes < 1 || options.nodes > 254 || options.baud_rate == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Party> parties(1);
+    int status{0};
+
+    try {
+        std::string name;
+        parties.front().name = "host";
+        parties.front().fd = host::open_pty(name);
+
+        // Keep the slave side open so the PTY never hangs up between clients.
+        if (::open(name.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC) < 0) {
+            throw os_error(name);
+        }
+
+        for (unsigned address{1}; address <= options.nodes; address++) {
+            parties.push_back(spawn(options, address));
+        }
+
+        printf("%s\n", name.c_str());
+        fflush(stdout);
+
+        // Start, data and stop bit.
+        const auto character{std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(10.0 / options.baud_rate))};
+        auto next{Clock::now()};
+        std::vector<pollfd> fds(parties.size());
+
+        while (running) {
+            const bool busy{std::any_of(parties.begin(), parties.end(), [](const Party& party) { return !party.queue.empty(); })};
+
+            for (size_t i{0}; i < parties.size(); i++) {
+                fds[i] = pollfd{parties[i].fd, POLLIN, 0};
+            }
+
+            if (::poll(fds.data(), fds.size(), busy ? 1 : 100) < 0 && errno != EINTR) {
+                throw os_error("poll");
+            }
+
+            for (size_t i{0}; i < parties.size(); i++) {
+                if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !receive(parties[i])) {
+                    throw std::runtime_error{parties[i].name + " is gone"};
+                }
+            }
+
+            // Catch up one character time at a time, an idle wire does not bank time.
+            const auto now{Clock::now()};
+
+            if (!busy) {
+                next = now;
+            }
+
+            for (; next <= now; next += character) {
+                transfer(parties);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        status = 1;
+    }
+
+    for (Party& party : parties) {
+        if (party.pid > 0) {
+            ::kill(party.pid, SIGTERM);
+            ::waitpid(party.pid, nullptr, 0);
+        }
+    }
+
+    for (const Party& party : parties) {
+        fprintf(stderr, "%-8s %8lu bytes sent, %lu collisions, %lu overruns\n", party.name.c_str(), party.sent, party.collisions, party.overruns);
+    }
+
+    return status;
+}
@@ -0,0 +1,327 @@
+/**
+ * Closed-loop fault sweep of GasBurnerControl against the emulated burner
+ * control box. Every combination of box timings and faults runs in simulated
+ * time from start() until the controller settles, checking that it never
+ * reports running without a flame, powers down in every error state, never
+ * holds the reset, always settles and ends up running if there is no fault,
+ * unless the box is slower than GasBurnerControl waits for.
+ */
+#include "arduino/sim.h"
+#include "burner-box.h"
+#include "burner-pins.h"
+#include <GasBurnerControl.h>
+#include <chrono>
+#include <cstdio>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+using host::BurnerBox;
+using State = GasBurner::State;
+
+namespace {
+    /// Period of gbc_task in app.cpp.
+    constexpr uint32_t update_period{50};
+    /// A flame missing for longer while the controller reports running fails.
+    constexpr uint32_t max_flame_mismatch{1000};
+    /// The reset held for longer fails, the controller presses it for 1 s.
+    constexpr uint32_t max_reset_press{5000};
+    /// Running this long beyond any pending flame loss counts as settled.
+    constexpr uint32_t settle_time{60000};
+
+    struct Options {
+        /// Simulated minutes per scenario before it counts as stuck.
+        uint32_t horizon{30};
+        bool verbose{false};
+    };
+
+    struct Scenario {
+        BurnerBox::Timing timing;
+        BurnerBox::Faults faults;
+    };
+
+    struct Dimension {
+        const char* name;
+        std::vector<uint32_t> values;
+        void (*apply)(Scenario&, uint32_t);
+    };
+
+    /// Box timings around the ones GasBurnerControl assumes.
+    const Dimension dimensions[] = {
+        {"ignition_delay", {1000, gbc::start_delay * 1000U, 2500, 10000, gbc::start_timeout * 1000U - 1000, gbc::start_timeout * 1000U + 5000}, [](Scenario& s, uint32_t v) { s.timing.ignition_delay = v; }},
+        {"flame_delay", {3000, gbc::safety_time * 1000U}, [](Scenario& s, uint32_t v) { s.timing.flame_delay = v; }},
+        {"reset_lock", {gbc::dejam_delay_1 * 1000U - 10000, gbc::dejam_delay_1 * 1000U, gbc::dejam_delay_1 * 1000U + 5000}, [](Scenario& s, uint32_t v) { s.timing.reset_lock = v; }},
+        {"reset_press", {300, gbc::dejam_duration, gbc::dejam_duration + 500U}, [](Scenario& s, uint32_t v) { s.timing.reset_press = v; }},
+        {"no_gas", {0, 1}, [](Scenario& s, uint32_t v) { s.faults.no_gas = v; }},
+        {"failed_ignitions", {0, 1, 2, 3}, [](Scenario& s, uint32_t v) { s.faults.failed_ignitions = v; }},
+        {"jammed", {0, 1}, [](Scenario& s, uint32_t v) { s.faults.locked_at_start = v; }},
+        {"flame_loss", {0, 30000, 600000}, [](Scenario& s, uint32_t v) { s.faults.flame_loss_after = v; }},
+        {"reset_ignored", {0, 1}, [](Scenario& s, uint32_t v) { s.faults.reset_ignored = v; }},
+    };
+
+    constexpr size_t num_dimensions{sizeof(dimensions) / sizeof(dimensions[0])};
+
+    /// Outcomes are running and the error states, stuck for anything else.
+    enum Outcome { running, error_start, error_ignition, error_dejam, error_other, stuck, num_outcomes };
+
+    const char* const outcome_names[num_outcomes] = {"running", "error_start", "error_ignition", "error_dejam", "error_other", "stuck"};
+
+    bool fault_free(const BurnerBox::Faults& faults)
+    {
+        return !faults.no_gas && faults.failed_ignitions == 0 && !faults.locked_at_start && faults.flame_loss_after == 0 && !faults.reset_ignored;
+    }
+
+    /**
+     * Why a fault-free @p scenario cannot end up running, nullptr if it must.
+     */
+    const char* expected_failure(const Scenario& scenario)
+    {
+        if (scenario.timing.ignition_delay > gbc::start_timeout * 1000UL) {
+            return "box ignites after gbc::start_timeout, error_start";
+        }
+
+        return nullptr;
+    }
+
+    struct Result {
+        Outcome outcome;
+        /// Reason why the scenario does not end up running without faults.
+        const char* expected{nullptr};
+        /// First violated invariant, nullptr if none.
+        const char* violation{nullptr};
+        uint32_t violation_time{0};
+        uint32_t duration{0};
+        BurnerBox::Statistics box;
+    };
+
+    Outcome outcome_of(State state)
+    {
+        switch (state) {
+            case State::running:
+                return running;
+            case State::error_start:
+                return error_start;
+            case State::error_ignition:
+                return error_ignition;
+            case State::error_dejam:
+                return error_dejam;
+            case State::error_other:
+                return error_other;
+            default:
+                return stuck;
+        }
+    }
+
+    Result run(const Scenario& scenario, uint32_t horizon)
+    {
+        sim::reset();
+        sim::set_speed(0.0);
+
+        GasBurnerControl gbc{GBC_POWER_PIN, GBC_DEJAM_PIN, GBC_JAMMED_PIN, GBC_VALVE_PIN, GBC_IGNITION_PIN};
+        BurnerBox box{scenario.timing, scenario.faults};
+        Result result{};
+
+        gbc.begin();
+        gbc.start();
+
+        uint32_t flame_mismatch{0};
+        uint32_t reset_pressed{0};
+        uint32_t in_error{0};
+        uint32_t in_running{0};
+        uint32_t now{0};
+
+        auto violate = [&result, &now](const char* what) {
+            if (!result.violation) {
+                result.violation = what;
+                result.violation_time = now;
+            }
+        };
+
+        for (; now < horizon; now += update_period, sim::advance(update_period * 1000ULL)) {
+            const BurnerBox::Outputs outputs{host::update_burner_box(box)};
+            const bool powered{sim::output(GBC_POWER_PIN) == LOW};
+            const bool reset{sim::output(GBC_DEJAM_PIN) == LOW};
+
+            flame_mismatch = gbc.state() == State::running && !box.burning() ? flame_mismatch + update_period : 0;
+            reset_pressed = reset ? reset_pressed + update_period : 0;
+
+            if (flame_mismatch > max_flame_mismatch) {
+                violate("running without flame");
+            }
+
+            if (reset_pressed > max_reset_press) {
+                violate("reset held");
+            }
+
+            // The error state powers down on the update after entering it.
+            if (in_error > update_period && (powered || reset || outputs.valve)) {
+                violate("powered in error");
+            }
+
+            if (gbc.state() > State::any_error) {
+                if (in_error > update_period) {
+                    break;
+                }
+                in_error += update_period;
+            }
+
+            in_running = gbc.state() == State::running ? in_running + update_period : 0;
+
+            if (in_running > scenario.faults.flame_loss_after + settle_time) {
+                break;
+            }
+
+            gbc.update();
+        }
+
+        result.outcome = outcome_of(gbc.state());
+        result.duration = now;
+        result.box = box.statistics();
+
+        if (result.outcome == stuck) {
+            violate("not settled");
+        }
+        else if (fault_free(scenario.faults)) {
+            result.expected = expected_failure(scenario);
+
+            if (!result.expected && result.outcome != running) {
+                violate("not running without faults");
+            }
+            else if (result.expected && result.outcome != error_start) {
+                violate("no error_start after gbc::start_timeout");
+            }
+        }
+
+        return result;
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options]\n"
+                "  -H, --horizon MIN     simulated minutes before a scenario counts as stuck (default 30)\n"
+                "  -v, --verbose         print every scenario\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const option long_options[] = {
+        {"horizon", required_argument, nullptr, 'H'},
+        {"verbose", no_argument, nullptr, 'v'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "H:vh", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 'H':
+                options.horizon = std::stoul(optarg);
+                break;
+            case 'v':
+                options.verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc || options.horizon == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t num_scenarios{1};
+
+    for (const Dimension& dimension : dimensions) {
+        num_scenarios *= dimension.values.size();
+    }
+
+    // Outcome counts per dimension value, plus violations in the last column.
+    std::vector<std::vector<std::vector<unsigned>>> counts(num_dimensions);
+
+    for (size_t d = 0; d < num_dimensions; d++) {
+        counts[d].assign(dimensions[d].values.size(), std::vector<unsigned>(num_outcomes + 1, 0));
+    }
+
+    unsigned totals[num_outcomes]{};
+    unsigned violations{0};
+    unsigned expected_failures{0};
+    double simulated{0.0};
+    const auto start{std::chrono::steady_clock::now()};
+
+    for (size_t n = 0; n < num_scenarios; n++) {
+        Scenario scenario;
+        size_t index[num_dimensions];
+        std::string description;
+
+        // Mixed-radix decomposition of n, the last dimension varies fastest.
+        for (size_t d = num_dimensions, rest = n; d-- > 0;) {
+            index[d] = rest % dimensions[d].values.size();
+            rest /= dimensions[d].values.size();
+            dimensions[d].apply(scenario, dimensions[d].values[index[d]]);
+        }
+
+        for (size_t d = 0; d < num_dimensions; d++) {
+            description += std::string{d ? " " : ""} + dimensions[d].name + "=" + std::to_string(dimensions[d].values[index[d]]);
+        }
+
+        const Result result{run(scenario, options.horizon * 60000)};
+
+        simulated += result.duration / 1000.0;
+        totals[result.outcome]++;
+
+        for (size_t d = 0; d < num_dimensions; d++) {
+            counts[d][index[d]][result.outcome]++;
+            counts[d][index[d]][num_outcomes] += result.violation != nullptr;
+        }
+
+        if (result.violation) {
+            violations++;
+            printf("FAIL %s: %s at %.2f s\n", description.c_str(), result.violation, result.violation_time / 1000.0);
+        }
+        else if (result.expected) {
+            expected_failures++;
+            printf("XFAIL %s: %s\n", description.c_str(), result.expected);
+        }
+        else if (options.verbose) {
+            printf("%-14s %s (%.0f s, %u ignitions, %u lockouts, %u/%u resets)\n", outcome_names[result.outcome], description.c_str(), result.duration / 1000.0, result.box.ignitions, result.box.lockouts, result.box.resets_accepted, result.box.resets_accepted + result.box.resets_rejected);
+        }
+    }
+
+    const double wall{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+    printf("\n%-17s %8s", "dimension", "value");
+
+    for (const char* name : outcome_names) {
+        printf(" %14s", name);
+    }
+
+    printf(" %10s\n", "violations");
+
+    for (size_t d = 0; d < num_dimensions; d++) {
+        for (size_t v = 0; v < dimensions[d].values.size(); v++) {
+            printf("%-17s %8u", v ? "" : dimensions[d].name, dimensions[d].values[v]);
+
+            for (size_t o = 0; o < num_outcomes; o++) {
+                printf(" %14u", counts[d][v][o]);
+            }
+
+            printf(" %10u\n", counts[d][v][num_outcomes]);
+        }
+    }
+
+    printf("\n%zu scenarios, %.1f h simulated in %.2f s:", num_scenarios, simulated / 3600.0, wall);
+
+    for (size_t o = 0; o < num_outcomes; o++) {
+        printf(" %u %s%s", totals[o], outcome_names[o], o + 1 < num_outcomes ? "," : "");
+    }
+
+    printf("; %u expected failures, %u violations\n", expected_failures, violations);
+
+    return violations ? 2 : 0;
+}
@@ -0,0 +1,352 @@
+/**
+ * Protocol load tester measuring round-trip latency, lost replies and NACK
+ * rates of a brewslave (device, PTY or host build) under a command mix.
+ */
+#include "codec.h"
+#include "link.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <getopt.h>
+#include <map>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using protocol::Command;
+using protocol::Response;
+using Clock = std::chrono::steady_clock;
+namespace schema = protocol::schema;
+
+namespace {
+    struct Options {
+        std::string device;
+        uint32_t baud_rate{115200};
+        uint8_t address{1};
+        std::string mix{"read_state"};
+        /// Requests per second, 0 sends bursts instead.
+        double rate{20.0};
+        unsigned burst{8};
+        std::chrono::milliseconds duration{10000};
+        std::chrono::milliseconds timeout{500};
+    };
+
+    struct Kind {
+        const char* name;
+        Command command;
+    };
+
+    const Kind kinds[] = {
+        {"read_state", Command::read_state},
+        {"read_burner_full_state", Command::read_burner_full_state},
+        {"read_schedule", Command::read_schedule},
+        {"read_capabilities", Command::read_capabilities},
+        {"batch_get", Command::batch_get},
+        {"set_brew_temperature", Command::set_brew_temperature},
+        {"ping", Command::ping},
+    };
+
+    struct Statistics {
+        unsigned long sent{0};
+        unsigned long acked{0};
+        unsigned long nacked{0};
+        unsigned long lost{0};
+        std::vector<double> latencies; // milliseconds
+    };
+
+    struct Pending {
+        size_t kind;
+        Clock::time_point sent;
+    };
+
+    /**
+     * Parse "name[:weight],..." into kind indices and cumulative weights.
+     */
+    bool parse_mix(const std::string& mix, std::vector<size_t>& selected, std::vector<unsigned>& weights)
+    {
+        size_t start{0};
+
+        while (start < mix.size()) {
+            const size_t end{std::min(mix.find(',', start), mix.size())};
+            const std::string item{mix.substr(start, end - start)};
+            const size_t colon{item.find(':')};
+            const std::string name{item.substr(0, colon)};
+            const unsigned weight{colon == std::string::npos ? 1u : static_cast<unsigned>(std::stoul(item.substr(colon + 1)))};
+            const auto kind = std::find_if(std::begin(kinds), std::end(kinds), [&name](const Kind& k) { return name == k.name; });
+
+            if (kind == std::end(kinds) || weight == 0) {
+                fprintf(stderr, "Unknown mix entry '%s'\n", item.c_str());
+                return false;
+            }
+
+            selected.push_back(kind - std::begin(kinds));
+            weights.push_back((weights.empty() ? 0 : weights.back()) + weight);
+            start = end + 1;
+        }
+
+        return !selected.empty();
+    }
+
+    std::vector<uint8_t> make_request(Command command, uint8_t address, uint8_t sequence, std::mt19937& random)
+    {
+        switch (command) {
+            case Command::read_schedule: {
+                auto payload{host::request<schema::ChannelRequest>(address, sequence, command)};
+                schema::ChannelRequest::channel::store(host::data(payload), 0);
+                return payload;
+            }
+            case Command::batch_get: {
+                auto payload{host::request(address, sequence, command)};
+                payload.insert(payload.end(), {static_cast<uint8_t>(protocol::Field::brew_temperature), static_cast<uint8_t>(protocol::Field::sparging_temperature), static_cast<uint8_t>(protocol::Field::uptime)});
+                return payload;
+            }
+            case Command::set_brew_temperature: {
+                // Stays below any sensible mash temperature so the burner never fires.
+                auto payload{host::request<schema::SetTemperatureRequest>(address, sequence, command)};
+                schema::SetTemperatureRequest::temperature::store(host::data(payload), 20.0f);
+                return payload;
+            }
+            case Command::ping: {
+                auto payload{host::request(address, sequence, command)};
+
+                for (unsigned i = 0; i < 16; i++) {
+                    payload.push_back(static_cast<uint8_t>(random()));
+                }
+                return payload;
+            }
+            default:
+                return host::request(address, sequence, command);
+        }
+    }
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    }
+
+    void print_histogram(const std::vector<double>& latencies)
+    {
+        // Log2 buckets from 0.125 ms.
+        unsigned buckets[16]{};
+
+        for (const double latency : latencies) {
+            unsigned bucket{0};
+
+            for (double limit = 0.125; latency >= limit && bucket < 15; limit *= 2) {
+                bucket++;
+            }
+
+            buckets[bucket]++;
+        }
+
+        double limit{0.125};
+
+        for (unsigned i = 0; i < 16; limit *= 2, i++) {
+            if (buckets[i]) {
+                printf("  < %8.3f ms %8u\n", limit, buckets[i]);
+            }
+        }
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <device>\n"
+                "  -b, --baud RATE       baud rate (default 115200)\n"
+                "  -a, --address N       node address (default 1)\n"
+                "  -m, --mix LIST        command mix as name[:weight],... (default read_state)\n"
+                "  -r, --rate N          requests per second, 0 for bursts (default 20)\n"
+                "  -n, --burst N         requests per pipelined burst (default 8)\n"
+                "  -d, --duration MS     test duration (default 10000)\n"
+                "  -t, --timeout MS      reply timeout (default 500)\n"
+                "Commands: read_state, read_burner_full_state, read_schedule, read_capabilities,\n"
+                "          batch_get, set_brew_temperature, ping\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const option long_options[] = {
+        {"baud", required_argument, nullptr, 'b'},
+        {"address", required_argument, nullptr, 'a'},
+        {"mix", required_argument, nullptr, 'm'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"burst", required_argument, nullptr, 'n'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"timeout", required_argument, nullptr, 't'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "b:a:m:r:n:d:t:h", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 'b':
+                options.baud_rate = std::stoul(optarg);
+                break;
+            case 'a':
+                options.address = static_cast<uint8_t>(std::stoul(optarg));
+                break;
+            case 'm':
+                options.mix = optarg;
+                break;
+            case 'r':
+                options.rate = std::stod(optarg);
+                break;
+            case 'n':
+                options.burst = std::max(1ul, std::min(255ul, std::stoul(optarg)));
+                break;
+            case 'd':
+                options.duration = std::chrono::milliseconds{std::stoul(optarg)};
+                break;
+            case 't':
+                options.timeout = std::chrono::milliseconds{std::stoul(optarg)};
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    std::vector<size_t> selected;
+    std::vector<unsigned> weights;
+
+    if (optind + 1 != argc || !parse_mix(options.mix, selected, weights)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    options.device = argv[optind];
+
+    try {
+        host::FrameStream stream{host::open_serial(options.device, options.baud_rate)};
+        std::mt19937 random{1};
+        std::map<uint8_t, Pending> pending;
+        std::vector<Statistics> statistics(std::size(kinds));
+        unsigned long unexpected{0};
+        uint8_t sequence{0};
+
+        const auto start{Clock::now()};
+        const auto end{start + options.duration};
+        const auto interval{options.rate > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{1.0 / options.rate}) : Clock::duration::zero()};
+        auto next_send{start};
+
+        const auto on_frame = [&](const uint8_t* data, uint8_t size) {
+            const auto now{Clock::now()};
+
+            if (size < 3 || data[0] != options.address || (data[2] & ~protocol::response_mask) == static_cast<uint8_t>(Command::telemetry)) {
+                return;
+            }
+
+            const auto request = pending.find(data[1]);
+
+            if (request == pending.end() || (data[2] & ~protocol::response_mask) != static_cast<uint8_t>(kinds[request->second.kind].command)) {
+                unexpected++;
+                return;
+            }
+
+            auto& kind{statistics[request->second.kind]};
+            (data[2] & static_cast<uint8_t>(Response::ack)) ? kind.acked++ : kind.nacked++;
+            kind.latencies.push_back(std::chrono::duration<double, std::milli>(now - request->second.sent).count());
+            pending.erase(request);
+        };
+
+        const auto send = [&](Clock::time_point now) {
+            const unsigned pick{static_cast<unsigned>(random() % weights.back())};
+            const size_t kind{selected[std::upper_bound(weights.begin(), weights.end(), pick) - weights.begin()]};
+
+            // Never reuse a sequence number still waiting for its reply.
+            while (pending.count(++sequence)) {
+            }
+
+            if (!stream.send(make_request(kinds[kind].command, options.address, sequence, random))) {
+                throw std::runtime_error{"write failed"};
+            }
+
+            pending[sequence] = Pending{kind, now};
+            statistics[kind].sent++;
+        };
+
+        while (Clock::now() < end || !pending.empty()) {
+            const auto now{Clock::now()};
+
+            for (auto request = pending.begin(); request != pending.end();) {
+                if (now - request->second.sent > options.timeout) {
+                    statistics[request->second.kind].lost++;
+                    request = pending.erase(request);
+                }
+                else {
+                    ++request;
+                }
+            }
+
+            if (now < end) {
+                if (options.rate > 0) {
+                    // Open loop: keep the schedule even if replies are late.
+                    while (next_send <= now && pending.size() < 255) {
+                        send(now);
+                        next_send += interval;
+                    }
+                }
+                else if (pending.empty()) {
+                    for (unsigned i = 0; i < options.burst; i++) {
+                        send(now);
+                    }
+                }
+            }
+
+            pollfd fd{stream.fd(), static_cast<short>(POLLIN | (stream.wants_write() ? POLLOUT : 0)), 0};
+            ::poll(&fd, 1, 1);
+
+            if (fd.revents & POLLOUT) {
+                stream.flush();
+            }
+
+            if ((fd.revents & POLLIN) && !stream.receive(on_frame)) {
+                throw std::runtime_error{"device closed"};
+            }
+        }
+
+        const double seconds{std::chrono::duration<double>(Clock::now() - start).count()};
+        Statistics total;
+
+        printf("%-24s %8s %8s %8s %8s %9s %9s %9s\n", "command", "sent", "acked", "nacked", "lost", "p50 ms", "p99 ms", "max ms");
+
+        for (size_t i = 0; i < statistics.size(); i++) {
+            auto& kind{statistics[i]};
+
+            if (kind.sent == 0) {
+                continue;
+            }
+
+            std::sort(kind.latencies.begin(), kind.latencies.end());
+            printf("%-24s %8lu %8lu %8lu %8lu %9.3f %9.3f %9.3f\n", kinds[i].name, kind.sent, kind.acked, kind.nacked, kind.lost, percentile(kind.latencies, 0.5), percentile(kind.latencies, 0.99), kind.latencies.empty() ? 0.0 : kind.latencies.back());
+
+            total.sent += kind.sent;
+            total.acked += kind.acked;
+            total.nacked += kind.nacked;
+            total.lost += kind.lost;
+            total.latencies.insert(total.latencies.end(), kind.latencies.begin(), kind.latencies.end());
+        }
+
+        std::sort(total.latencies.begin(), total.latencies.end());
+        printf("%-24s %8lu %8lu %8lu %8lu %9.3f %9.3f %9.3f\n", "total", total.sent, total.acked, total.nacked, total.lost, percentile(total.latencies, 0.5), percentile(total.latencies, 0.99), total.latencies.empty() ? 0.0 : total.latencies.back());
+        printf("\n%.1f replies/s, NACK rate %.2f %%, loss rate %.2f %%, %lu unexpected and %lu corrupt frames\n\nLatency histogram:\n", (total.acked + total.nacked) / seconds, total.sent ? 100.0 * total.nacked / total.sent : 0.0, total.sent ? 100.0 * total.lost / total.sent : 0.0, unexpected, stream.errors());
+        print_histogram(total.latencies);
+
+        return total.lost > 0 ? 2 : 0;
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+}
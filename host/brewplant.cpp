@@ -0,0 +1,178 @@
+/**
+ * Closed-loop brew simulation: the real MainController from controller.cpp
+ * heating a brew and a sparging kettle through the thermal plant in plant.h,
+ * in simulated time. Prints rise and settling time, overshoot and relay
+ * cycles per channel and optionally the trajectory as CSV.
+ */
+#include "brew-run.h"
+#include <cstdio>
+#include <fstream>
+#include <getopt.h>
+#include <stdexcept>
+#include <string>
+
+using host::Metrics;
+
+namespace {
+    struct Options {
+        host::BrewRun run;
+        std::string csv;
+    };
+
+    void print_metrics(const char* channel, float target, const Metrics& metrics, float temperature)
+    {
+        char rise[16] = "-";
+        char settling[16] = "-";
+
+        if (metrics.rise_time() >= 0.0f) {
+            snprintf(rise, sizeof(rise), "%.0f", metrics.rise_time());
+        }
+
+        if (metrics.settling_time() >= 0.0f) {
+            snprintf(settling, sizeof(settling), "%.0f", metrics.settling_time());
+        }
+
+        printf("%-9s %7.1f %7s %10s %10.2f %7u %9.0f %8.2f\n", channel, target, rise, settling, metrics.overshoot(), metrics.cycles(), metrics.on_time(), temperature);
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options]\n"
+                "  -m, --mode MODE             brew control: hysteresis, predictive or pid (default hysteresis)\n"
+                "  -M, --sparging-mode MODE    sparging control: hysteresis or pid (default hysteresis)\n"
+                "  -b, --brew C                brew target in degree Celsius, 0 is off (default 66)\n"
+                "  -s, --sparging C            sparging target in degree Celsius, 0 is off (default 0)\n"
+                "  -k, --brew-kettle SPEC      brew kettle as key=value,... with volume (L), power (W),\n"
+                "                              loss (W/K), ambient, initial (degree Celsius), heat-lag and\n"
+                "                              probe-lag (s), default volume=50,power=10000,loss=10,heat-lag=30\n"
+                "  -K, --sparging-kettle SPEC  sparging kettle, default volume=30,power=2000,loss=10,heat-lag=60\n"
+                "  -g, --brew-gains KP,KI,KD   store PID gains of the brew channel\n"
+                "  -G, --sparging-gains KP,KI,KD\n"
+                "                              store PID gains of the sparging channel\n"
+                "  -H, --hysteresis C          half-width of the switching band (default 1)\n"
+                "      --min-on S              minimum burner on time, predictive mode (default 60)\n"
+                "      --min-off S             minimum burner off time, predictive mode (default 60)\n"
+                "  -D, --dead-time S           burner start to running (default 24)\n"
+                "  -r, --resolution C          sensor quantization (default 0.0625)\n"
+                "  -B, --band C                half-width of the band counting as reached and settled (default 0.5)\n"
+                "  -d, --duration MIN          simulated minutes (default 120)\n"
+                "  -c, --csv FILE              write time, temperatures and heater states every second\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    enum { min_on = 256, min_off };
+
+    const option long_options[] = {
+        {"mode", required_argument, nullptr, 'm'},
+        {"sparging-mode", required_argument, nullptr, 'M'},
+        {"brew", required_argument, nullptr, 'b'},
+        {"sparging", required_argument, nullptr, 's'},
+        {"brew-kettle", required_argument, nullptr, 'k'},
+        {"sparging-kettle", required_argument, nullptr, 'K'},
+        {"brew-gains", required_argument, nullptr, 'g'},
+        {"sparging-gains", required_argument, nullptr, 'G'},
+        {"hysteresis", required_argument, nullptr, 'H'},
+        {"min-on", required_argument, nullptr, min_on},
+        {"min-off", required_argument, nullptr, min_off},
+        {"dead-time", required_argument, nullptr, 'D'},
+        {"resolution", required_argument, nullptr, 'r'},
+        {"band", required_argument, nullptr, 'B'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"csv", required_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    try {
+        for (int c; (c = getopt_long(argc, argv, "m:M:b:s:k:K:g:G:H:D:r:B:d:c:h", long_options, nullptr)) != -1;) {
+            switch (c) {
+                case 'm':
+                    options.run.brew_mode = host::parse_mode(optarg);
+                    break;
+                case 'M':
+                    options.run.sparging_mode = host::parse_mode(optarg);
+                    break;
+                case 'b':
+                    options.run.brew_target = std::stof(optarg);
+                    break;
+                case 's':
+                    options.run.sparging_target = std::stof(optarg);
+                    break;
+                case 'k':
+                    host::parse_kettle(optarg, options.run.brew_kettle);
+                    break;
+                case 'K':
+                    host::parse_kettle(optarg, options.run.sparging_kettle);
+                    break;
+                case 'g':
+                    options.run.brew_gains = host::parse_gains(optarg);
+                    break;
+                case 'G':
+                    options.run.sparging_gains = host::parse_gains(optarg);
+                    break;
+                case 'H':
+                    options.run.parameters.hysteresis = std::stof(optarg);
+                    break;
+                case min_on:
+                    options.run.parameters.min_on_time = std::stoul(optarg);
+                    break;
+                case min_off:
+                    options.run.parameters.min_off_time = std::stoul(optarg);
+                    break;
+                case 'D':
+                    options.run.dead_time = std::stof(optarg);
+                    break;
+                case 'r':
+                    options.run.resolution = std::stof(optarg);
+                    break;
+                case 'B':
+                    options.run.band = std::stof(optarg);
+                    break;
+                case 'd':
+                    options.run.duration = std::stoul(optarg) * 60000UL;
+                    break;
+                case 'c':
+                    options.csv = optarg;
+                    break;
+                default:
+                    usage(argv[0]);
+                    return c == 'h' ? 0 : 1;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (optind != argc || options.run.resolution <= 0.0f) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ofstream csv;
+
+    if (!options.csv.empty()) {
+        csv.open(options.csv);
+
+        if (!csv) {
+            fprintf(stderr, "Error: cannot write %s\n", options.csv.c_str());
+            return 1;
+        }
+    }
+
+    const host::BrewResult result{host::simulate(options.run, csv.is_open() ? &csv : nullptr)};
+
+    printf("%-9s %7s %7s %10s %10s %7s %9s %8s\n", "channel", "target", "rise", "settling", "overshoot", "cycles", "on_time", "final");
+    print_metrics("brew", options.run.brew_target, result.brew, result.brew_temperature);
+    print_metrics("sparging", options.run.sparging_target, result.sparging, result.sparging_temperature);
+
+    return 0;
+}
@@ -0,0 +1,641 @@
+/**
+ * Multiplexing proxy between one brewslave serial link and any number of
+ * local clients on a Unix socket.
+ *
+ * Clients speak the regular frame protocol. Reads are answered from a cache
+ * kept warm by a poll loop, identical reads in flight are coalesced, writes
+ * are serialized and invalidate the cache. Subscriptions are merged into one
+ * device subscription and telemetry is fanned out to all subscribers, trace
+ * records likewise.
+ */
+#include "../protocol.h"
+#include "link.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <getopt.h>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <set>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <unistd.h>
+
+using protocol::Command;
+using protocol::Response;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        std::string device;
+        std::string socket_path{"/tmp/brewproxy.sock"};
+        uint32_t baud_rate{115200};
+        uint8_t address{1};
+        std::chrono::milliseconds poll_interval{500};
+        std::chrono::milliseconds max_age{1000};
+        std::chrono::milliseconds timeout{250};
+    };
+
+    /// Address, code and data of a request, used as cache key.
+    using Key = std::vector<uint8_t>;
+
+    bool is_read(Command command)
+    {
+        switch (command) {
+            case Command::read_state:
+            case Command::read_burner_full_state:
+            case Command::read_autotune:
+            case Command::read_schedule:
+            case Command::batch_get:
+            case Command::read_capabilities:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    struct Subscription {
+        uint16_t period;
+        uint16_t deadband;
+
+        bool operator==(const Subscription& other) const { return period == other.period && deadband == other.deadband; }
+        bool operator!=(const Subscription& other) const { return !(*this == other); }
+    };
+
+    struct Client {
+        explicit Client(int fd)
+        : stream{fd}
+        {
+        }
+
+        host::FrameStream stream;
+        std::map<uint8_t, Subscription> subscriptions;
+        std::set<uint8_t> traces;
+    };
+
+    /// Client waiting for a reply to the request it sent with @c sequence.
+    struct Waiter {
+        int client;
+        uint8_t sequence;
+    };
+
+    struct Request {
+        Key key;
+        std::vector<Waiter> waiters;
+    };
+
+    struct Entry {
+        std::vector<uint8_t> reply; // code and data
+        Clock::time_point time;
+    };
+
+    volatile std::sig_atomic_t running{1};
+
+    void stop(int) { running = 0; }
+
+    class Proxy {
+    public:
+        Proxy(const Options& options, int device, int listener)
+        : m_options{options}
+        , m_device{device}
+        , m_listener{listener}
+        {
+        }
+
+        void run();
+
+    private:
+        void accept_client();
+        void handle_client_frame(int id, const uint8_t* data, uint8_t size);
+        void handle_device_frame(const uint8_t* data, uint8_t size);
+        void reply(const Waiter& waiter, uint8_t address, const std::vector<uint8_t>& reply);
+        void reply(int id, uint8_t address, uint8_t sequence, uint8_t code);
+        void enqueue(Key key, const Waiter* waiter);
+        void send_next();
+        void fail_inflight();
+        void update_subscription(uint8_t address);
+        void update_trace(uint8_t address);
+        void drop(int id);
+        int poll_timeout() const;
+
+        const Options& m_options;
+        host::FrameStream m_device;
+        int m_listener;
+        std::map<int, std::unique_ptr<Client>> m_clients;
+        int m_next_client{0};
+        std::map<Key, Entry> m_cache;
+        std::deque<Request> m_queue;
+        std::unique_ptr<Request> m_inflight;
+        Clock::time_point m_inflight_time;
+        uint8_t m_sequence{0};
+        Clock::time_point m_next_poll{Clock::now()};
+        std::map<uint8_t, Subscription> m_device_subscriptions;
+        std::set<uint8_t> m_device_traces;
+        std::vector<int> m_dead;
+    };
+
+    void Proxy::run()
+    {
+        std::vector<pollfd> fds;
+        std::vector<int> ids;
+
+        while (running) {
+            fds.clear();
+            ids.clear();
+            fds.push_back({m_device.fd(), static_cast<short>(POLLIN | (m_device.wants_write() ? POLLOUT : 0)), 0});
+            fds.push_back({m_listener, POLLIN, 0});
+
+            for (const auto& client : m_clients) {
+                fds.push_back({client.second->stream.fd(), static_cast<short>(POLLIN | (client.second->stream.wants_write() ? POLLOUT : 0)), 0});
+                ids.push_back(client.first);
+            }
+
+            if (::poll(fds.data(), fds.size(), poll_timeout()) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error{errno, std::generic_category(), "poll"};
+            }
+
+            if (fds[0].revents & POLLOUT) {
+                m_device.flush();
+            }
+
+            if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (!m_device.receive([this](const uint8_t* data, uint8_t size) { handle_device_frame(data, size); })) {
+                    throw std::runtime_error{"device closed"};
+                }
+            }
+
+            if (fds[1].revents & POLLIN) {
+                accept_client();
+            }
+
+            for (size_t i = 0; i < ids.size(); i++) {
+                const int id{ids[i]};
+                const short events{fds[i + 2].revents};
+                auto client = m_clients.find(id);
+
+                if (client == m_clients.end() || !events) {
+                    continue;
+                }
+
+                bool alive{true};
+
+                if (events & POLLOUT) {
+                    alive = client->second->stream.flush();
+                }
+
+                if (alive && (events & (POLLIN | POLLHUP | POLLERR))) {
+                    alive = client->second->stream.receive([this, id](const uint8_t* data, uint8_t size) { handle_client_frame(id, data, size); });
+                }
+
+                if (!alive) {
+                    m_dead.push_back(id);
+                }
+            }
+
+            // Clients are only dropped here, never while one of their frames is handled.
+            for (const int id : m_dead) {
+                drop(id);
+            }
+
+            m_dead.clear();
+
+            const auto now{Clock::now()};
+
+            if (m_inflight && now - m_inflight_time > m_options.timeout) {
+                fail_inflight();
+            }
+
+            // Keep the state everyone reads warm, without clients in the loop.
+            if (now >= m_next_poll) {
+                m_next_poll = now + m_options.poll_interval;
+                enqueue({m_options.address, static_cast<uint8_t>(Command::read_state)}, nullptr);
+            }
+
+            send_next();
+        }
+    }
+
+    int Proxy::poll_timeout() const
+    {
+        auto deadline{m_next_poll};
+
+        if (m_inflight) {
+            deadline = std::min(deadline, m_inflight_time + m_options.timeout);
+        }
+
+        const auto wait{std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count()};
+        return static_cast<int>(std::max<long long>(wait + 1, 0));
+    }
+
+    void Proxy::accept_client()
+    {
+        const int fd{::accept4(m_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+
+        if (fd >= 0) {
+            m_clients.emplace(m_next_client++, std::unique_ptr<Client>{new Client{fd}});
+        }
+    }
+
+    void Proxy::drop(int id)
+    {
+        auto client = m_clients.find(id);
+
+        if (client == m_clients.end()) {
+            return;
+        }
+
+        const auto subscriptions{client->second->subscriptions};
+        const auto traces{client->second->traces};
+        m_clients.erase(client);
+
+        for (const auto& subscription : subscriptions) {
+            update_subscription(subscription.first);
+        }
+
+        for (const uint8_t address : traces) {
+            update_trace(address);
+        }
+    }
+
+    void Proxy::handle_client_frame(int id, const uint8_t* data, uint8_t size)
+    {
+        if (size < 3) {
+            return;
+        }
+
+        const uint8_t address{data[0]};
+        const uint8_t sequence{data[1]};
+        const Command command{static_cast<Command>(data[2])};
+        const Waiter waiter{id, sequence};
+        Key key{data[0]};
+        key.insert(key.end(), data + 2, data + size);
+
+        if (address == frame::broadcast_address) {
+            // Nobody answers broadcasts, just keep them in order with the writes.
+            m_cache.clear();
+            enqueue(key, nullptr);
+            return;
+        }
+
+        switch (command) {
+            case Command::subscribe: {
+                using M = protocol::schema::SubscribeRequest;
+
+                if (size != 3 + M::size) {
+                    reply(id, address, sequence, data[2] | static_cast<uint8_t>(Response::nack));
+                    return;
+                }
+
+                const Subscription subscription{M::period::load(data + 3), M::deadband::load(data + 3)};
+                auto& subscriptions{m_clients.at(id)->subscriptions};
+
+                if (subscription.period == 0) {
+                    subscriptions.erase(address);
+                }
+                else {
+                    subscriptions[address] = subscription;
+                }
+
+                reply(id, address, sequence, data[2] | static_cast<uint8_t>(Response::ack));
+                update_subscription(address);
+                return;
+            }
+            case Command::subscribe_trace: {
+                using M = protocol::schema::SubscribeTraceRequest;
+
+                if (size != 3 + M::size) {
+                    reply(id, address, sequence, data[2] | static_cast<uint8_t>(Response::nack));
+                    return;
+                }
+
+                auto& traces{m_clients.at(id)->traces};
+
+                if (M::enable::load(data + 3)) {
+                    traces.insert(address);
+                }
+                else {
+                    traces.erase(address);
+                }
+
+                reply(id, address, sequence, data[2] | static_cast<uint8_t>(Response::ack));
+                update_trace(address);
+                return;
+            }
+            case Command::set_baud_rate:
+                // The link belongs to the proxy.
+                reply(id, address, sequence, data[2] | static_cast<uint8_t>(Response::nack));
+                return;
+            default:
+                break;
+        }
+
+        if (!is_read(command)) {
+            enqueue(key, &waiter);
+            return;
+        }
+
+        const auto entry = m_cache.find(key);
+
+        if (entry != m_cache.end() && Clock::now() - entry->second.time < m_options.max_age) {
+            reply(waiter, address, entry->second.reply);
+            return;
+        }
+
+        // Piggyback on an identical read that is already on its way.
+        if (m_inflight && m_inflight->key == key) {
+            m_inflight->waiters.push_back(waiter);
+            return;
+        }
+
+        for (auto& request : m_queue) {
+            if (request.key == key) {
+                request.waiters.push_back(waiter);
+                return;
+            }
+        }
+
+        enqueue(key, &waiter);
+    }
+
+    void Proxy::handle_device_frame(const uint8_t* data, uint8_t size)
+    {
+        if (size < 3) {
+            return;
+        }
+
+        const uint8_t address{data[0]};
+        const uint8_t code{data[2]};
+
+        if ((code & ~protocol::response_mask) == static_cast<uint8_t>(Command::telemetry)) {
+            // Something changed, cached reads of that node are stale.
+            for (auto entry = m_cache.begin(); entry != m_cache.end();) {
+                entry = entry->first[0] == address ? m_cache.erase(entry) : std::next(entry);
+            }
+
+            for (auto& client : m_clients) {
+                if (client.second->subscriptions.count(address) && !client.second->stream.send(data, size)) {
+                    m_dead.push_back(client.first);
+                }
+            }
+
+            return;
+        }
+
+        if ((code & ~protocol::response_mask) == static_cast<uint8_t>(Command::trace)) {
+            for (auto& client : m_clients) {
+                if (client.second->traces.count(address) && !client.second->stream.send(data, size)) {
+                    m_dead.push_back(client.first);
+                }
+            }
+
+            return;
+        }
+
+        if (!m_inflight || address != m_inflight->key[0] || data[1] != m_sequence) {
+            return;
+        }
+
+        const std::vector<uint8_t> reply_data(data + 2, data + size);
+        const auto command{static_cast<Command>(m_inflight->key[1])};
+
+        if (is_read(command)) {
+            if (code & static_cast<uint8_t>(Response::ack)) {
+                m_cache[m_inflight->key] = Entry{reply_data, Clock::now()};
+            }
+        }
+        else {
+            m_cache.clear();
+        }
+
+        for (const auto& waiter : m_inflight->waiters) {
+            reply(waiter, address, reply_data);
+        }
+
+        m_inflight.reset();
+    }
+
+    void Proxy::reply(const Waiter& waiter, uint8_t address, const std::vector<uint8_t>& reply)
+    {
+        auto client = m_clients.find(waiter.client);
+
+        if (client == m_clients.end()) {
+            return;
+        }
+
+        std::vector<uint8_t> payload{address, waiter.sequence};
+        payload.insert(payload.end(), reply.begin(), reply.end());
+
+        if (!client->second->stream.send(payload)) {
+            m_dead.push_back(waiter.client);
+        }
+    }
+
+    void Proxy::reply(int id, uint8_t address, uint8_t sequence, uint8_t code)
+    {
+        reply(Waiter{id, sequence}, address, {code});
+    }
+
+    void Proxy::enqueue(Key key, const Waiter* waiter)
+    {
+        Request request{std::move(key), {}};
+
+        if (waiter) {
+            request.waiters.push_back(*waiter);
+        }
+
+        m_queue.push_back(std::move(request));
+    }
+
+    void Proxy::send_next()
+    {
+        while (!m_inflight && !m_queue.empty()) {
+            m_inflight.reset(new Request{std::move(m_queue.front())});
+            m_queue.pop_front();
+
+            std::vector<uint8_t> payload{m_inflight->key[0], ++m_sequence};
+            payload.insert(payload.end(), m_inflight->key.begin() + 1, m_inflight->key.end());
+
+            if (!m_device.send(payload)) {
+                throw std::runtime_error{"device write failed"};
+            }
+
+            m_inflight_time = Clock::now();
+
+            if (m_inflight->key[0] == frame::broadcast_address) {
+                m_inflight.reset();
+            }
+        }
+    }
+
+    void Proxy::fail_inflight()
+    {
+        const uint8_t address{m_inflight->key[0]};
+        const uint8_t nack{static_cast<uint8_t>(m_inflight->key[1] | static_cast<uint8_t>(Response::nack))};
+
+        for (const auto& waiter : m_inflight->waiters) {
+            reply(waiter, address, {nack});
+        }
+
+        m_inflight.reset();
+    }
+
+    void Proxy::update_subscription(uint8_t address)
+    {
+        // The device pushes at the fastest period and the finest deadband anyone asked for.
+        Subscription merged{0, 0};
+
+        for (const auto& client : m_clients) {
+            auto subscription = client.second->subscriptions.find(address);
+
+            if (subscription == client.second->subscriptions.end()) {
+                continue;
+            }
+
+            const bool first{merged.period == 0};
+            merged.period = first ? subscription->second.period : std::min(merged.period, subscription->second.period);
+            merged.deadband = first ? subscription->second.deadband : std::min(merged.deadband, subscription->second.deadband);
+        }
+
+        auto current = m_device_subscriptions.find(address);
+
+        if ((current == m_device_subscriptions.end() && merged.period == 0) || (current != m_device_subscriptions.end() && current->second == merged)) {
+            return;
+        }
+
+        m_device_subscriptions[address] = merged;
+
+        using M = protocol::schema::SubscribeRequest;
+        Key key{address, static_cast<uint8_t>(Command::subscribe)};
+        key.resize(2 + M::size);
+        M::period::store(key.data() + 2, merged.period);
+        M::deadband::store(key.data() + 2, merged.deadband);
+        enqueue(key, nullptr);
+    }
+
+    void Proxy::update_trace(uint8_t address)
+    {
+        const bool enable{std::any_of(m_clients.begin(), m_clients.end(), [address](const std::pair<const int, std::unique_ptr<Client>>& client) { return client.second->traces.count(address) > 0; })};
+
+        if (enable == (m_device_traces.count(address) > 0)) {
+            return;
+        }
+
+        if (enable) {
+            m_device_traces.insert(address);
+        }
+        else {
+            m_device_traces.erase(address);
+        }
+
+        enqueue({address, static_cast<uint8_t>(Command::subscribe_trace), static_cast<uint8_t>(enable)}, nullptr);
+    }
+
+    int listen_unix(const std::string& path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument{"socket path too long"};
+        }
+
+        strcpy(address.sun_path, path.c_str());
+        ::unlink(path.c_str());
+
+        const int fd{::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, 16) < 0) {
+            throw std::system_error{errno, std::generic_category(), path};
+        }
+
+        return fd;
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <device>\n"
+                "  -s, --socket PATH     Unix socket to serve (default /tmp/brewproxy.sock)\n"
+                "  -b, --baud RATE       baud rate (default 115200)\n"
+                "  -a, --address N       node address to poll (default 1)\n"
+                "  -p, --poll MS         read_state poll interval (default 500)\n"
+                "  -m, --max-age MS      serve cached reads up to this age (default 1000)\n"
+                "  -t, --timeout MS      reply timeout (default 250)\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const option long_options[] = {
+        {"socket", required_argument, nullptr, 's'},
+        {"baud", required_argument, nullptr, 'b'},
+        {"address", required_argument, nullptr, 'a'},
+        {"poll", required_argument, nullptr, 'p'},
+        {"max-age", required_argument, nullptr, 'm'},
+        {"timeout", required_argument, nullptr, 't'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "s:b:a:p:m:t:h", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 's':
+                options.socket_path = optarg;
+                break;
+            case 'b':
+                options.baud_rate = std::stoul(optarg);
+                break;
+            case 'a':
+                options.address = static_cast<uint8_t>(std::stoul(optarg));
+                break;
+            case 'p':
+                options.poll_interval = std::chrono::milliseconds{std::stoul(optarg)};
+                break;
+            case 'm':
+                options.max_age = std::chrono::milliseconds{std::stoul(optarg)};
+                break;
+            case 't':
+                options.timeout = std::chrono::milliseconds{std::stoul(optarg)};
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind + 1 != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    options.device = argv[optind];
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    try {
+        Proxy proxy{options, host::open_serial(options.device, options.baud_rate), listen_unix(options.socket_path)};
+        proxy.run();
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        ::unlink(options.socket_path.c_str());
+        return 1;
+    }
+
+    ::unlink(options.socket_path.c_str());
+    return 0;
+}
@@ -0,0 +1,246 @@
+/**
+ * Replay an input trace recorded with brewtrace --record against the
+ * firmware built for Linux. Time advances by a fixed step per loop pass and
+ * every recorded input event, pin change and sensor reading is applied at its
+ * recorded millisecond, so a bug seen on the device reproduces here under a
+ * debugger, and two replays of the same trace drive the display identically.
+ * Input events are queued as the interrupts queued them, pin levels are set
+ * without running the interrupts again.
+ */
+#include "../controller.h"
+#include "../input.h"
+#include "../input_trace.h"
+#include "../sensor.h"
+#include "../trace_events.h"
+#include "arduino/sim.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <SPI.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <getopt.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern MockTemperatureSensor brew_sensor;
+extern MockTemperatureSensor sparging_sensor;
+extern MainController controller;
+
+namespace {
+    enum class Event : uint8_t {
+#define TRACE_ENUM(name, format) name,
+        TRACE_EVENTS(TRACE_ENUM)
+#undef TRACE_ENUM
+    };
+
+    const char* const event_names[] = {
+#define TRACE_NAME(name, format) #name,
+        TRACE_EVENTS(TRACE_NAME)
+#undef TRACE_NAME
+    };
+
+    struct Record {
+        uint32_t time;
+        Event event;
+        uint16_t a;
+        uint16_t b;
+    };
+
+    struct Options {
+        /// Microseconds per loop pass.
+        uint64_t step{100};
+        /// Milliseconds to keep running after the last record.
+        uint64_t tail{1000};
+        std::string eeprom;
+        bool csv{false};
+    };
+
+    /**
+     * Read the records of @p path, unknown events are skipped.
+     *
+     * @throw std::runtime_error if the file cannot be read or is malformed.
+     */
+    std::vector<Record> load_trace(const std::string& path)
+    {
+        std::ifstream file{path};
+
+        if (!file) {
+            throw std::runtime_error{"cannot read " + path};
+        }
+
+        std::vector<Record> records;
+        std::string line;
+        unsigned number{0};
+
+        while (std::getline(file, line)) {
+            number++;
+
+            if (number == 1 || line.empty()) {
+                continue;
+            }
+
+            std::istringstream fields{line};
+            std::string time, name, a, b;
+
+            if (!std::getline(fields, time, ',') || !std::getline(fields, name, ',') || !std::getline(fields, a, ',') || !std::getline(fields, b)) {
+                throw std::runtime_error{path + ":" + std::to_string(number) + ": expected time,event,a,b"};
+            }
+
+            for (uint8_t id = 0; id < sizeof(event_names) / sizeof(event_names[0]); id++) {
+                if (name == event_names[id]) {
+                    records.push_back(Record{static_cast<uint32_t>(std::stoul(time)), static_cast<Event>(id), static_cast<uint16_t>(std::stoul(a)), static_cast<uint16_t>(std::stoul(b))});
+                    break;
+                }
+            }
+        }
+
+        return records;
+    }
+
+    void load_eeprom(const std::string& path)
+    {
+        std::ifstream file{path, std::ios::binary};
+
+        if (!file.read(reinterpret_cast<char*>(EEPROM.data()), EEPROM.length())) {
+            throw std::runtime_error{"cannot read " + path};
+        }
+    }
+
+    /**
+     * Drive the inputs, pins and sensors as recorded in @p record.
+     */
+    void apply(const Record& record)
+    {
+        switch (record.event) {
+            case Event::input_pins:
+                for (uint8_t i = 0; i < static_cast<uint8_t>(input_trace::Input::count); i++) {
+                    const uint8_t pin{input_trace::pin(static_cast<input_trace::Input>(i))};
+
+                    if ((record.b & (1 << i)) && pin != input_trace::no_pin) {
+                        sim::hold_input(pin, (record.a >> i) & 1);
+                    }
+                }
+                break;
+            case Event::input_event:
+                input::push(static_cast<input::Source>(record.a), static_cast<int8_t>(static_cast<int16_t>(record.b)));
+                break;
+            case Event::input_brew_sensor:
+                brew_sensor.set(static_cast<int16_t>(record.a) / 16.0f, record.b);
+                break;
+            case Event::input_sparging_sensor:
+                sparging_sensor.set(static_cast<int16_t>(record.a) / 16.0f, record.b);
+                break;
+            case Event::overflow:
+                fprintf(stderr, "warning: %u records dropped at %u ms, the replay diverges from here\n", record.a, record.time);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <trace.csv>\n"
+                "  -t, --step US         advance time by US microseconds per loop pass (default 100)\n"
+                "  -T, --tail MS         keep running MS milliseconds after the last record (default 1000)\n"
+                "  -e, --eeprom FILE     load EEPROM contents from FILE, it is not written back\n"
+                "  -c, --csv             print the controller state every second as CSV\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const option long_options[] = {
+        {"step", required_argument, nullptr, 't'},
+        {"tail", required_argument, nullptr, 'T'},
+        {"eeprom", required_argument, nullptr, 'e'},
+        {"csv", no_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "t:T:e:ch", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 't':
+                options.step = std::stoull(optarg);
+                break;
+            case 'T':
+                options.tail = std::stoull(optarg);
+                break;
+            case 'e':
+                options.eeprom = optarg;
+                break;
+            case 'c':
+                options.csv = true;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind + 1 != argc || options.step == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        const std::vector<Record> records{load_trace(argv[optind])};
+
+        if (records.empty()) {
+            throw std::runtime_error{"no input records, was the trace recorded from a with_input_trace build?"};
+        }
+
+        if (!options.eeprom.empty()) {
+            load_eeprom(options.eeprom);
+        }
+
+        sim::set_speed(0.0);
+
+        if (options.csv) {
+            printf("time,brew,brew_target,sparging,sparging_target,full_burner_state,hotplate\n");
+        }
+
+        const auto start{std::chrono::steady_clock::now()};
+        const uint64_t end{(records.back().time + options.tail) * 1000};
+        unsigned long long passes{0};
+        size_t next{0};
+        uint64_t next_sample{0};
+
+        setup();
+
+        while (sim::now() < end) {
+            while (next < records.size() && records[next].time <= millis()) {
+                apply(records[next++]);
+            }
+
+            loop();
+            passes++;
+
+            if (options.csv && sim::now() >= next_sample) {
+                printf("%.3f,%.2f,%.1f,%.2f,%.1f,%u,%u\n", sim::now() / 1e6, controller.brew_temperature(), controller.brew_target_temperature(), controller.sparging_temperature(), controller.sparging_target_temperature(), controller.full_burner_state(), controller.sparging_heater_is_on());
+                next_sample += 1000000;
+            }
+
+            sim::advance(options.step);
+        }
+
+        const double wall{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+        fprintf(stderr, "%zu records replayed over %.3f s in %.3f s, %llu loop passes\n", records.size(), sim::now() / 1e6, wall, passes);
+        fprintf(stderr, "display checksum %08x over %lu bytes\n", SPI.checksum(), SPI.bytes());
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * The firmware built for Linux against the Arduino shim in arduino/, talking
+ * the protocol on a PTY. Time either follows the wall clock, optionally
+ * scaled, or advances by a fixed step per loop pass for fast deterministic
+ * runs under perf or callgrind. GasBurnerControl is connected to an emulated
+ * burner control box with optional faults.
+ *
+ * Built as brewslave-rs485 the node only puts bytes on the PTY while it
+ * drives RS485_DE_PIN, see brewbus.
+ */
+#include "arduino/sim.h"
+#include "burner-box.h"
+#include "burner-pins.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <getopt.h>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    struct Options {
+        double speed{1.0};
+        /// Microseconds per loop pass, 0 follows the wall clock.
+        uint64_t step{0};
+        /// Simulated milliseconds to run, 0 runs until interrupted.
+        uint64_t duration{0};
+        /// Initial clock value in milliseconds.
+        uint64_t start{0};
+        std::string eeprom;
+        host::BurnerBox::Faults faults;
+    };
+
+    volatile std::sig_atomic_t running{1};
+
+    void stop(int) { running = 0; }
+
+    void load_eeprom(const std::string& path)
+    {
+        std::ifstream file{path, std::ios::binary};
+        file.read(reinterpret_cast<char*>(EEPROM.data()), EEPROM.length());
+    }
+
+    void save_eeprom(const std::string& path)
+    {
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+
+        if (!file.write(reinterpret_cast<const char*>(EEPROM.data()), EEPROM.length())) {
+            throw std::runtime_error{"cannot write " + path};
+        }
+    }
+
+    void add_fault(host::BurnerBox::Faults& faults, const std::string& spec)
+    {
+        const auto equals{spec.find('=')};
+        const std::string name{spec.substr(0, equals)};
+        const std::string value{equals == std::string::npos ? "" : spec.substr(equals + 1)};
+
+        if (name == "no-gas") {
+            faults.no_gas = true;
+        }
+        else if (name == "failed-ignitions" && !value.empty()) {
+            faults.failed_ignitions = std::stoul(value);
+        }
+        else if (name == "jammed") {
+            faults.locked_at_start = true;
+        }
+        else if (name == "flame-loss" && !value.empty()) {
+            faults.flame_loss_after = std::stoul(value);
+        }
+        else if (name == "reset-ignored") {
+            faults.reset_ignored = true;
+        }
+        else {
+            throw std::invalid_argument{"unknown fault " + spec};
+        }
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options]\n"
+                "  -s, --speed FACTOR    run time FACTOR times faster than the wall clock (default 1)\n"
+                "  -t, --step US         advance time by US microseconds per loop pass instead\n"
+                "  -d, --duration MS     stop after MS simulated milliseconds\n"
+                "  -S, --start MS        start the clock at MS, 4294960000 wraps the 32-bit\n"
+                "                        millisecond clock after 7.3 s\n"
+                "  -e, --eeprom FILE     load EEPROM contents from and save them to FILE\n"
+                "  -f, --fault FAULT     inject a burner box fault, repeatable: no-gas,\n"
+                "                        failed-ignitions=N, jammed, flame-loss=MS, reset-ignored\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const option long_options[] = {
+        {"speed", required_argument, nullptr, 's'},
+        {"step", required_argument, nullptr, 't'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"start", required_argument, nullptr, 'S'},
+        {"eeprom", required_argument, nullptr, 'e'},
+        {"fault", required_argument, nullptr, 'f'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "s:t:d:S:e:f:h", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 's':
+                options.speed = std::stod(optarg);
+                break;
+            case 't':
+                options.step = std::stoull(optarg);
+                break;
+            case 'd':
+                options.duration = std::stoull(optarg);
+                break;
+            case 'S':
+                options.start = std::stoull(optarg);
+                break;
+            case 'e':
+                options.eeprom = optarg;
+                break;
+            case 'f':
+                try {
+                    add_fault(options.faults, optarg);
+                }
+                catch (const std::exception&) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc || options.speed <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    try {
+        if (!options.eeprom.empty()) {
+            load_eeprom(options.eeprom);
+        }
+
+        printf("%s\n", sim::open_serial().c_str());
+        fflush(stdout);
+
+        sim::advance(options.start * 1000);
+        sim::set_speed(options.step ? 0.0 : options.speed);
+
+        const auto start{std::chrono::steady_clock::now()};
+        unsigned long long passes{0};
+        host::BurnerBox box{host::BurnerBox::Timing{}, options.faults};
+
+#if defined(WITH_RS485)
+        sim::set_driver_enable(RS485_DE_PIN);
+#endif
+
+        setup();
+
+        const uint64_t origin{sim::now()};
+
+        while (running && (options.duration == 0 || sim::now() - origin < options.duration * 1000)) {
+            host::update_burner_box(box);
+            loop();
+            passes++;
+
+            if (options.step) {
+                sim::advance(options.step);
+                sim::poll_serial(0);
+            }
+            else {
+                // Sleeping on the PTY keeps an idle real-time simulation off the CPU.
+                sim::poll_serial(options.speed > 1.0 ? 0 : 1);
+            }
+        }
+
+        const double wall{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+        const double simulated{(sim::now() - origin) / 1e6};
+
+        const host::BurnerBox::Statistics& burner{box.statistics()};
+
+        fprintf(stderr, "%.3f s simulated in %.3f s (%.1fx), %llu loop passes, %.0f passes/s\n", simulated, wall, wall > 0 ? simulated / wall : 0.0, passes, wall > 0 ? passes / wall : 0.0);
+#if defined(WITH_RS485)
+        fprintf(stderr, "RS-485 node %u: %lu bytes sent with the driver disabled\n", RS485_ADDRESS, sim::discarded_bytes());
+#endif
+        fprintf(stderr, "burner box: %u ignitions, %u lockouts, %u resets accepted, %u rejected\n", burner.ignitions, burner.lockouts, burner.resets_accepted, burner.resets_rejected);
+
+        if (!options.eeprom.empty()) {
+            save_eeprom(options.eeprom);
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
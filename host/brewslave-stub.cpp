@@ -0,0 +1,158 @@
+/**
+ * Minimal brewslave stand-in on a PTY for testing host tools without
+ * hardware. Temperatures approach their targets slowly, telemetry is pushed
+ * like the firmware does.
+ */
+#include "codec.h"
+#include "link.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+
+using protocol::Command;
+using protocol::Response;
+namespace schema = protocol::schema;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct State {
+        float brew{20.0f};
+        float brew_target{20.0f};
+        float sparging{20.0f};
+        float sparging_target{20.0f};
+    };
+
+    int16_t centi_degrees(float temperature) { return static_cast<int16_t>(std::lround(temperature * 100.0f)); }
+
+    /**
+     * Grow @p reply by message @p M and return its data.
+     */
+    template <typename M>
+    uint8_t* append(std::vector<uint8_t>& reply)
+    {
+        reply.resize(reply.size() + M::size);
+        return reply.data() + reply.size() - M::size;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint8_t address{static_cast<uint8_t>(argc > 1 ? std::atoi(argv[1]) : 1)};
+    std::string name;
+    host::FrameStream stream{host::open_pty(name)};
+    State state;
+    uint16_t telemetry_period{0};
+    uint8_t telemetry_sequence{0};
+    auto last_telemetry{Clock::now()};
+    auto last_step{Clock::now()};
+
+    // Keep the slave side open ourselves so the master never sees a hangup between clients.
+    const int slave{::open(name.c_str(), O_RDWR | O_NOCTTY)};
+
+    if (slave < 0) {
+        perror(name.c_str());
+        return 1;
+    }
+
+    printf("%s\n", name.c_str());
+    fflush(stdout);
+
+    const auto handle = [&](const uint8_t* data, uint8_t size) {
+        if (size < 3 || (data[0] != address && data[0] != frame::broadcast_address) || (data[2] & protocol::response_mask)) {
+            return;
+        }
+
+        const Command command{static_cast<Command>(data[2])};
+        const uint8_t* payload{data + 3};
+        const uint8_t payload_size{static_cast<uint8_t>(size - 3)};
+        std::vector<uint8_t> reply{address, data[1], static_cast<uint8_t>(data[2] | static_cast<uint8_t>(Response::ack))};
+        bool ok{true};
+
+        switch (command) {
+            case Command::read_state: {
+                using M = schema::ReadStateReply;
+                uint8_t* out{append<M>(reply)};
+                M::brew::store(out, state.brew, true);
+                M::brew_target::store(out, state.brew_target);
+                M::sparging::store(out, state.sparging, true);
+                M::sparging_target::store(out, state.sparging_target);
+                M::state::store(out, 0);
+            } break;
+            case Command::set_brew_temperature:
+            case Command::set_sparging_temperature:
+                ok = payload_size == schema::SetTemperatureRequest::size;
+
+                if (ok) {
+                    (command == Command::set_brew_temperature ? state.brew_target : state.sparging_target) = schema::SetTemperatureRequest::temperature::load(payload);
+                }
+                break;
+            case Command::read_burner_full_state:
+                schema::ReadBurnerFullStateReply::state::store(append<schema::ReadBurnerFullStateReply>(reply), 0);
+                break;
+            case Command::subscribe:
+                ok = payload_size == schema::SubscribeRequest::size;
+
+                if (ok) {
+                    telemetry_period = schema::SubscribeRequest::period::load(payload);
+                }
+                break;
+            case Command::read_capabilities: {
+                using M = schema::ReadCapabilitiesReply;
+                uint8_t* out{append<M>(reply)};
+                M::version::store(out, protocol::version);
+                M::fields::store(out, 0);
+                M::features::store(out, 0);
+                reply.insert(reply.end(), {'s', 't', 'u', 'b'});
+            } break;
+            case Command::ping:
+                reply.insert(reply.end(), payload, payload + payload_size);
+                break;
+            default:
+                ok = false;
+                break;
+        }
+
+        if (!ok) {
+            reply.resize(3);
+            reply[2] = data[2] | static_cast<uint8_t>(Response::nack);
+        }
+
+        if (data[0] != frame::broadcast_address) {
+            stream.send(reply);
+        }
+    };
+
+    while (true) {
+        pollfd fd{stream.fd(), static_cast<short>(POLLIN | (stream.wants_write() ? POLLOUT : 0)), 0};
+        ::poll(&fd, 1, 10);
+
+        if (fd.revents & POLLOUT) {
+            stream.flush();
+        }
+
+        // Without a connected slave side the master reports POLLHUP, wait for a peer.
+        if ((fd.revents & POLLIN) && !stream.receive(handle)) {
+            return 0;
+        }
+
+        const auto now{Clock::now()};
+
+        if (now - last_step >= std::chrono::seconds{1}) {
+            last_step = now;
+            state.brew += (state.brew_target - state.brew) * 0.1f;
+            state.sparging += (state.sparging_target - state.sparging) * 0.1f;
+        }
+
+        if (telemetry_period > 0 && now - last_telemetry >= std::chrono::milliseconds{telemetry_period}) {
+            last_telemetry = now;
+            const protocol::Telemetry telemetry{centi_degrees(state.brew), centi_degrees(state.brew_target), centi_degrees(state.sparging), centi_degrees(state.sparging_target), 0, 0};
+            std::vector<uint8_t> frame{address, telemetry_sequence++, static_cast<uint8_t>(static_cast<uint8_t>(Command::telemetry) | static_cast<uint8_t>(Response::ack))};
+            schema::TelemetryPush::store(append<schema::TelemetryPush>(frame), telemetry);
+            stream.send(frame);
+        }
+    }
+}
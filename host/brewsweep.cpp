@@ -0,0 +1,340 @@
+/**
+ * Parallel controller parameter sweep: closed-loop brew simulations of the
+ * real MainController against the thermal plant over a parameter grid and
+ * several batch sizes, one simulated device per thread. Prints the Pareto
+ * front of time to setpoint, overshoot and burner cycles per batch size.
+ */
+#include "brew-run.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <getopt.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using host::BrewResult;
+using host::BrewRun;
+using Mode = MainController::Mode;
+
+namespace {
+    enum Parameter { mode, hysteresis, min_on, min_off, kp, ki, kd, num_parameters };
+
+    struct Dimension {
+        const char* name;
+        std::vector<float> values;
+        /// Modes the parameter matters for, as bits of Mode.
+        unsigned modes;
+    };
+
+    constexpr unsigned bit_of(Mode m) { return 1u << static_cast<unsigned>(m); }
+
+    constexpr unsigned all_modes{bit_of(Mode::hysteresis) | bit_of(Mode::predictive) | bit_of(Mode::pid)};
+
+    struct Options {
+        BrewRun run;
+        std::vector<float> volumes{20.0f, 35.0f, 50.0f, 70.0f, 100.0f};
+        Dimension dimensions[num_parameters] = {
+            {"mode", {0.0f, 1.0f, 2.0f}, all_modes},
+            {"hysteresis", {0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f}, bit_of(Mode::hysteresis) | bit_of(Mode::predictive)},
+            {"min-on", {0.0f, 30.0f, 60.0f, 120.0f, 180.0f}, bit_of(Mode::predictive)},
+            {"min-off", {0.0f, 30.0f, 60.0f, 120.0f, 180.0f}, bit_of(Mode::predictive)},
+            {"kp", {0.02f, 0.05f, 0.1f, 0.2f, 0.5f}, bit_of(Mode::pid)},
+            {"ki", {0.0f, 0.00005f, 0.0001f, 0.0002f, 0.0005f}, bit_of(Mode::pid)},
+            {"kd", {0.0f, 10.0f, 30.0f, 60.0f}, bit_of(Mode::pid)},
+        };
+        unsigned jobs{std::max(1u, std::thread::hardware_concurrency())};
+        bool all{false};
+    };
+
+    const char* const mode_names[] = {"hysteresis", "predictive", "pid"};
+
+    struct Point {
+        float volume;
+        /// Value of every parameter, those irrelevant for the mode at their first value.
+        float values[num_parameters];
+    };
+
+    struct Outcome {
+        float rise;
+        float settling;
+        float overshoot;
+        unsigned cycles;
+    };
+
+    std::vector<float> parse_values(const std::string& list, bool modes)
+    {
+        std::vector<float> values;
+        size_t start{0};
+
+        while (start < list.size()) {
+            const size_t end{std::min(list.find(',', start), list.size())};
+            const std::string item{list.substr(start, end - start)};
+
+            values.push_back(modes ? static_cast<float>(host::parse_mode(item)) : std::stof(item));
+            start = end + 1;
+        }
+
+        if (values.empty()) {
+            throw std::invalid_argument{"no values in " + list};
+        }
+
+        return values;
+    }
+
+    void parse_parameter(const std::string& spec, Options& options)
+    {
+        const size_t equals{spec.find('=')};
+        const std::string name{spec.substr(0, equals)};
+
+        for (size_t p = 0; p < num_parameters; p++) {
+            if (equals != std::string::npos && name == options.dimensions[p].name) {
+                options.dimensions[p].values = parse_values(spec.substr(equals + 1), p == mode);
+                return;
+            }
+        }
+
+        throw std::invalid_argument{"unknown parameter " + spec};
+    }
+
+    /**
+     * Cross product of volumes and parameters, skipping variations of
+     * parameters the mode ignores.
+     */
+    std::vector<Point> grid(const Options& options)
+    {
+        std::vector<Point> points;
+        size_t combinations{1};
+
+        for (const Dimension& dimension : options.dimensions) {
+            combinations *= dimension.values.size();
+        }
+
+        for (float volume : options.volumes) {
+            for (size_t n = 0; n < combinations; n++) {
+                Point point{volume, {}};
+                size_t index[num_parameters];
+
+                for (size_t p = num_parameters, rest = n; p-- > 0;) {
+                    index[p] = rest % options.dimensions[p].values.size();
+                    rest /= options.dimensions[p].values.size();
+                    point.values[p] = options.dimensions[p].values[index[p]];
+                }
+
+                const unsigned mode_bit{1u << static_cast<unsigned>(point.values[mode])};
+                bool redundant{false};
+
+                for (size_t p = 0; p < num_parameters; p++) {
+                    redundant = redundant || (!(options.dimensions[p].modes & mode_bit) && index[p] != 0);
+                }
+
+                if (!redundant) {
+                    points.push_back(point);
+                }
+            }
+        }
+
+        return points;
+    }
+
+    BrewRun make_run(const Options& options, const Point& point)
+    {
+        BrewRun run{options.run};
+
+        run.brew_kettle.volume = point.volume;
+        run.brew_mode = static_cast<Mode>(point.values[mode]);
+        run.parameters.hysteresis = point.values[hysteresis];
+        run.parameters.min_on_time = static_cast<uint16_t>(point.values[min_on]);
+        run.parameters.min_off_time = static_cast<uint16_t>(point.values[min_off]);
+        run.brew_gains = Gains{point.values[kp], point.values[ki], point.values[kd]};
+        run.sparging_target = 0.0f;
+        return run;
+    }
+
+    bool dominates(const Outcome& a, const Outcome& b)
+    {
+        const bool no_worse{a.rise <= b.rise && a.overshoot <= b.overshoot && a.cycles <= b.cycles};
+        const bool better{a.rise < b.rise || a.overshoot < b.overshoot || a.cycles < b.cycles};
+        return no_worse && better;
+    }
+
+    void print_point(const Options& options, const Point& point, const Outcome& outcome)
+    {
+        const unsigned mode_bit{1u << static_cast<unsigned>(point.values[mode])};
+
+        printf("%6.0f %-10s", point.volume, mode_names[static_cast<size_t>(point.values[mode])]);
+
+        for (size_t p = hysteresis; p < num_parameters; p++) {
+            if (options.dimensions[p].modes & mode_bit) {
+                printf(" %8g", point.values[p]);
+            }
+            else {
+                printf(" %8s", "-");
+            }
+        }
+
+        char settling[16] = "-";
+
+        if (outcome.settling >= 0.0f) {
+            snprintf(settling, sizeof(settling), "%.0f", outcome.settling);
+        }
+
+        printf(" %6.0f %8s %9.2f %6u\n", outcome.rise, settling, outcome.overshoot, outcome.cycles);
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options]\n"
+                "  -j, --jobs N           simulation threads (default: number of CPUs)\n"
+                "  -V, --volumes L,...    batch sizes in litres (default 20,35,50,70,100)\n"
+                "  -p, --param NAME=V,... values of a grid parameter: mode (hysteresis, predictive,\n"
+                "                         pid), hysteresis, min-on, min-off, kp, ki, kd\n"
+                "  -k, --kettle SPEC      brew kettle as in brewplant, the volume is swept\n"
+                "  -b, --brew C           brew target in degree Celsius (default 66)\n"
+                "  -D, --dead-time S      burner start to running (default 24)\n"
+                "  -B, --band C           half-width of the band counting as reached (default 0.5)\n"
+                "  -d, --duration MIN     simulated minutes per run (default 120)\n"
+                "  -a, --all              print every run instead of the Pareto front\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const option long_options[] = {
+        {"jobs", required_argument, nullptr, 'j'},
+        {"volumes", required_argument, nullptr, 'V'},
+        {"param", required_argument, nullptr, 'p'},
+        {"kettle", required_argument, nullptr, 'k'},
+        {"brew", required_argument, nullptr, 'b'},
+        {"dead-time", required_argument, nullptr, 'D'},
+        {"band", required_argument, nullptr, 'B'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"all", no_argument, nullptr, 'a'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    try {
+        for (int c; (c = getopt_long(argc, argv, "j:V:p:k:b:D:B:d:ah", long_options, nullptr)) != -1;) {
+            switch (c) {
+                case 'j':
+                    options.jobs = std::stoul(optarg);
+                    break;
+                case 'V':
+                    options.volumes = parse_values(optarg, false);
+                    break;
+                case 'p':
+                    parse_parameter(optarg, options);
+                    break;
+                case 'k':
+                    host::parse_kettle(optarg, options.run.brew_kettle);
+                    break;
+                case 'b':
+                    options.run.brew_target = std::stof(optarg);
+                    break;
+                case 'D':
+                    options.run.dead_time = std::stof(optarg);
+                    break;
+                case 'B':
+                    options.run.band = std::stof(optarg);
+                    break;
+                case 'd':
+                    options.run.duration = std::stoul(optarg) * 60000UL;
+                    break;
+                case 'a':
+                    options.all = true;
+                    break;
+                default:
+                    usage(argv[0]);
+                    return c == 'h' ? 0 : 1;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (optind != argc || options.jobs == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const std::vector<Point> points{grid(options)};
+    std::vector<Outcome> outcomes(points.size());
+    std::atomic<size_t> next{0};
+    const auto start{std::chrono::steady_clock::now()};
+
+    // Runs are independent, each thread simulates its own device.
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < points.size();) {
+            const BrewResult result{host::simulate(make_run(options, points[i]))};
+            outcomes[i] = Outcome{result.brew.rise_time(), result.brew.settling_time(), result.brew.overshoot(), result.brew.cycles()};
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (unsigned j = 0; j < options.jobs; j++) {
+        threads.emplace_back(worker);
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const double wall{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+    printf("%6s %-10s", "volume", "mode");
+
+    for (size_t p = hysteresis; p < num_parameters; p++) {
+        printf(" %8s", options.dimensions[p].name);
+    }
+
+    printf(" %6s %8s %9s %6s\n", "rise", "settling", "overshoot", "cycles");
+
+    size_t reached{0};
+
+    for (float volume : options.volumes) {
+        std::vector<size_t> front;
+
+        for (size_t i = 0; i < points.size(); i++) {
+            if (points[i].volume != volume || outcomes[i].rise < 0.0f) {
+                continue;
+            }
+
+            reached++;
+
+            const bool dominated{std::any_of(points.begin(), points.end(), [&](const Point& other) {
+                const size_t j = &other - points.data();
+                return other.volume == volume && outcomes[j].rise >= 0.0f && dominates(outcomes[j], outcomes[i]);
+            })};
+
+            // Of runs with identical outcomes only the first is shown.
+            const bool repeated{std::any_of(front.begin(), front.end(), [&](size_t j) {
+                return outcomes[j].rise == outcomes[i].rise && outcomes[j].overshoot == outcomes[i].overshoot && outcomes[j].cycles == outcomes[i].cycles;
+            })};
+
+            if (options.all || (!dominated && !repeated)) {
+                front.push_back(i);
+            }
+        }
+
+        std::sort(front.begin(), front.end(), [&outcomes](size_t a, size_t b) { return outcomes[a].rise < outcomes[b].rise; });
+
+        for (size_t i : front) {
+            print_point(options, points[i], outcomes[i]);
+        }
+    }
+
+    printf("\n%zu runs, %.1f h simulated on %u threads in %.2f s, %zu reached the target\n", points.size(), points.size() * options.run.duration / 3600000.0, options.jobs, wall, reached);
+
+    return 0;
+}
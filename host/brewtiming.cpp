@@ -0,0 +1,245 @@
+/**
+ * Read the loop and task runtime statistics of a brewslave built with
+ * with_timing and its memory usage, directly on the serial device or through
+ * brewproxy's socket.
+ */
+#include "../timing_phases.h"
+#include "codec.h"
+#include "link.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <getopt.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using protocol::Command;
+using protocol::Response;
+namespace schema = protocol::schema;
+
+namespace {
+    struct Phase {
+        const char* name;
+        const char* description;
+    };
+
+    const Phase phases[] = {
+#define TIMING_TABLE(name, description) {#name, description},
+        TIMING_PHASES(TIMING_TABLE)
+#undef TIMING_TABLE
+    };
+
+    constexpr uint8_t num_phases{sizeof(phases) / sizeof(phases[0])};
+
+    /// Time to wait for a reply in milliseconds.
+    constexpr int timeout{1000};
+
+    /**
+     * Send @p request and return the data of the matching reply.
+     *
+     * @throw std::runtime_error on NACK or timeout.
+     */
+    std::vector<uint8_t> transact(host::FrameStream& stream, const std::vector<uint8_t>& request)
+    {
+        std::vector<uint8_t> reply;
+        bool done{false};
+        const auto deadline{std::chrono::steady_clock::now() + std::chrono::milliseconds{timeout}};
+
+        const auto on_frame = [&](const uint8_t* data, uint8_t size) {
+            if (size < 3 || data[0] != request[0] || data[1] != request[1] || (data[2] & ~protocol::response_mask) != request[2]) {
+                return;
+            }
+
+            if (data[2] & static_cast<uint8_t>(Response::nack)) {
+                throw std::runtime_error{request[2] == static_cast<uint8_t>(Command::read_timing) ? "read_timing refused, build with with_timing" : "request refused"};
+            }
+
+            reply.assign(data + 3, data + size);
+            done = true;
+        };
+
+        stream.send(request);
+
+        while (!done) {
+            const auto remaining{std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count()};
+
+            if (remaining <= 0) {
+                throw std::runtime_error{"no reply"};
+            }
+
+            pollfd fd{stream.fd(), static_cast<short>(POLLIN | (stream.wants_write() ? POLLOUT : 0)), 0};
+
+            if (::poll(&fd, 1, static_cast<int>(remaining)) <= 0) {
+                continue;
+            }
+
+            if (fd.revents & POLLOUT) {
+                stream.flush();
+            }
+
+            if ((fd.revents & POLLIN) && !stream.receive(on_frame)) {
+                throw std::runtime_error{"connection closed"};
+            }
+        }
+
+        return reply;
+    }
+
+    /**
+     * Lower bound of histogram bucket @p n in microseconds.
+     */
+    uint32_t bucket_start(uint8_t n) { return n == 0 ? 0 : 1UL << (n + 3); }
+
+    /**
+     * Print the statistics of every phase, optionally clearing them.
+     */
+    void print_timing(host::FrameStream& stream, uint8_t address, uint8_t& sequence, bool reset, bool histogram)
+    {
+        printf("%-8s %10s %10s %10s %10s  %s\n", "phase", "count", "min_us", "mean_us", "max_us", "description");
+
+        for (uint8_t p = 0; p < num_phases; p++) {
+            using M = schema::ReadTimingRequest;
+            using R = schema::ReadTimingReply;
+
+            auto request{host::request<M>(address, ++sequence, Command::read_timing)};
+            M::phase::store(host::data(request), p);
+            M::reset::store(host::data(request), reset);
+
+            const std::vector<uint8_t> reply{transact(stream, request)};
+
+            if (reply.size() != R::size + R::buckets * sizeof(uint16_t)) {
+                throw std::runtime_error{"malformed read_timing reply"};
+            }
+
+            const uint8_t* data{reply.data()};
+            const uint32_t count{R::count::load(data)};
+
+            if (count == 0) {
+                printf("%-8s %10u %10s %10s %10s  %s\n", phases[p].name, 0, "-", "-", "-", phases[p].description);
+                continue;
+            }
+
+            printf("%-8s %10u %10u %10u %10u  %s\n", phases[p].name, count, R::min::load(data), R::mean::load(data), R::max::load(data), phases[p].description);
+
+            if (!histogram) {
+                continue;
+            }
+
+            for (uint8_t n = 0; n < R::buckets; n++) {
+                uint16_t samples;
+                memcpy(&samples, data + R::size + n * sizeof(uint16_t), sizeof(samples));
+
+                if (samples == 0) {
+                    continue;
+                }
+
+                if (n == R::buckets - 1) {
+                    printf("%20u+ us %10u\n", bucket_start(n), samples);
+                }
+                else {
+                    printf("%12u-%8u us %10u\n", bucket_start(n), bucket_start(n + 1) - 1, samples);
+                }
+            }
+        }
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <device or brewproxy socket>\n"
+                "  -b, --baud RATE       baud rate (default 115200)\n"
+                "  -a, --address N       node address (default 1)\n"
+                "  -r, --reset           clear the statistics after reading them\n"
+                "  -H, --histogram       print the runtime histogram of every phase\n"
+                "  -m, --memory          print only the memory usage\n"
+                "  -s, --show            also scroll the memory usage through the display\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud_rate{115200};
+    uint8_t address{1};
+    bool reset{false};
+    bool histogram{false};
+    bool timing{true};
+    bool show{false};
+
+    const option long_options[] = {
+        {"baud", required_argument, nullptr, 'b'},
+        {"address", required_argument, nullptr, 'a'},
+        {"reset", no_argument, nullptr, 'r'},
+        {"histogram", no_argument, nullptr, 'H'},
+        {"memory", no_argument, nullptr, 'm'},
+        {"show", no_argument, nullptr, 's'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "b:a:rHmsh", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 'b':
+                baud_rate = std::stoul(optarg);
+                break;
+            case 'a':
+                address = static_cast<uint8_t>(std::stoul(optarg));
+                break;
+            case 'r':
+                reset = true;
+                break;
+            case 'H':
+                histogram = true;
+                break;
+            case 'm':
+                timing = false;
+                break;
+            case 's':
+                show = true;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind + 1 != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        host::FrameStream stream{host::open_link(argv[optind], baud_rate)};
+        uint8_t sequence{0};
+
+        if (timing) {
+            print_timing(stream, address, sequence, reset, histogram);
+        }
+
+        using M = schema::ReadMemoryRequest;
+        using R = schema::ReadMemoryReply;
+
+        auto request{host::request<M>(address, ++sequence, Command::read_memory)};
+        M::show::store(host::data(request), show);
+
+        const std::vector<uint8_t> reply{transact(stream, request)};
+
+        if (reply.size() != R::size) {
+            throw std::runtime_error{"malformed read_memory reply"};
+        }
+
+        const uint8_t* data{reply.data()};
+        printf("%smemory: data %u, bss %u, heap %u, stack %u bytes, %u never used, %u free now\n", timing ? "\n" : "", R::data::load(data), R::bss::load(data), R::heap::load(data), R::stack::load(data), R::unused::load(data), R::free::load(data));
+
+        while (stream.wants_write() && stream.flush()) {
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/**
+ * Enable the trace channel of a brewslave and print its records, either
+ * directly on the serial device or through brewproxy's socket, optionally
+ * recording them for brewreplay.
+ */
+#include "../trace_events.h"
+#include "codec.h"
+#include "link.h"
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <getopt.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+
+using protocol::Command;
+using protocol::Response;
+namespace schema = protocol::schema;
+
+namespace {
+    struct Event {
+        const char* name;
+        const char* format;
+    };
+
+    const Event events[] = {
+#define TRACE_TABLE(name, format) {#name, format},
+        TRACE_EVENTS(TRACE_TABLE)
+#undef TRACE_TABLE
+    };
+
+    volatile std::sig_atomic_t running{1};
+
+    void stop(int) { running = 0; }
+
+    void print(const uint8_t* data)
+    {
+        using M = schema::TraceRecord;
+        const uint8_t id{M::event::load(data)};
+        const uint32_t time{M::time::load(data)};
+
+        printf("%10.3f  ", time / 1000.0);
+
+        if (id < sizeof(events) / sizeof(events[0])) {
+            printf("%-20s ", events[id].name);
+            printf(events[id].format, M::a::load(data), M::b::load(data));
+        }
+        else {
+            printf("unknown event %u (%u, %u)", id, M::a::load(data), M::b::load(data));
+        }
+
+        printf("\n");
+    }
+
+    void write_record(std::ostream& csv, const uint8_t* data)
+    {
+        using M = schema::TraceRecord;
+        const uint8_t id{M::event::load(data)};
+
+        csv << M::time::load(data) << ',';
+
+        if (id < sizeof(events) / sizeof(events[0])) {
+            csv << events[id].name;
+        }
+        else {
+            csv << static_cast<unsigned>(id);
+        }
+
+        csv << ',' << M::a::load(data) << ',' << M::b::load(data) << std::endl;
+    }
+
+    void usage(const char* name)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <device or brewproxy socket>\n"
+                "  -b, --baud RATE       baud rate (default 115200)\n"
+                "  -a, --address N       node address (default 1)\n"
+                "  -r, --record FILE     also write the records as time,event,a,b CSV\n",
+                name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud_rate{115200};
+    uint8_t address{1};
+    std::string record;
+
+    const option long_options[] = {
+        {"baud", required_argument, nullptr, 'b'},
+        {"address", required_argument, nullptr, 'a'},
+        {"record", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "b:a:r:h", long_options, nullptr)) != -1;) {
+        switch (c) {
+            case 'b':
+                baud_rate = std::stoul(optarg);
+                break;
+            case 'a':
+                address = static_cast<uint8_t>(std::stoul(optarg));
+                break;
+            case 'r':
+                record = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind + 1 != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    try {
+        std::ofstream csv;
+
+        if (!record.empty()) {
+            csv.open(record);
+
+            if (!csv) {
+                throw std::runtime_error{"cannot write " + record};
+            }
+
+            csv << "time,event,a,b\n";
+        }
+
+        host::FrameStream stream{host::open_link(argv[optind], baud_rate)};
+        uint8_t sequence{0};
+        uint8_t last_push{0};
+        bool first_push{true};
+
+        const auto subscribe = [&](bool enable) {
+            auto request{host::request<schema::SubscribeTraceRequest>(address, ++sequence, Command::subscribe_trace)};
+            schema::SubscribeTraceRequest::enable::store(host::data(request), enable);
+            stream.send(request);
+        };
+
+        const auto on_frame = [&](const uint8_t* data, uint8_t size) {
+            if (size < 3 || data[0] != address) {
+                return;
+            }
+
+            const uint8_t command{static_cast<uint8_t>(data[2] & ~protocol::response_mask)};
+
+            if (command == static_cast<uint8_t>(Command::subscribe_trace) && (data[2] & static_cast<uint8_t>(Response::nack))) {
+                throw std::runtime_error{"trace not supported by this build (WITH_TRACE)"};
+            }
+
+            if (command != static_cast<uint8_t>(Command::trace)) {
+                return;
+            }
+
+            // Pushes carry their own sequence, gaps mean lost frames.
+            if (!first_push && data[1] != static_cast<uint8_t>(last_push + 1)) {
+                printf("--- %u trace frames lost\n", static_cast<uint8_t>(data[1] - last_push - 1));
+            }
+
+            first_push = false;
+            last_push = data[1];
+
+            for (uint8_t offset = 3; offset + schema::TraceRecord::size <= size; offset += schema::TraceRecord::size) {
+                print(data + offset);
+
+                if (csv.is_open()) {
+                    write_record(csv, data + offset);
+                }
+            }
+
+            fflush(stdout);
+        };
+
+        subscribe(true);
+
+        while (running) {
+            pollfd fd{stream.fd(), static_cast<short>(POLLIN | (stream.wants_write() ? POLLOUT : 0)), 0};
+
+            if (::poll(&fd, 1, 100) < 0) {
+                continue;
+            }
+
+            if (fd.revents & POLLOUT) {
+                stream.flush();
+            }
+
+            if ((fd.revents & POLLIN) && !stream.receive(on_frame)) {
+                throw std::runtime_error{"connection closed"};
+            }
+        }
+
+        subscribe(false);
+
+        while (stream.wants_write() && stream.flush()) {
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "burner-box.h"
+
+using host::BurnerBox;
+
+BurnerBox::BurnerBox(const Timing& timing, const Faults& faults)
+: m_timing{timing}
+, m_faults{faults}
+, m_locked{faults.locked_at_start}
+, m_locked_before_start{faults.locked_at_start}
+{
+}
+
+BurnerBox::Outputs BurnerBox::update(uint32_t now, const Inputs& inputs)
+{
+    if (!inputs.power) {
+        // The lockout is stored in the box and survives a power cycle.
+        m_phase = Phase::off;
+        m_reset = false;
+        return Outputs{false, false, false};
+    }
+
+    if (inputs.reset && !m_reset) {
+        m_reset = true;
+        m_reset_start = now;
+    }
+    else if (!inputs.reset && m_reset) {
+        m_reset = false;
+
+        if (now - m_reset_start >= m_timing.reset_press) {
+            reset_released(now);
+        }
+    }
+
+    if (m_locked) {
+        m_phase = Phase::off;
+        return Outputs{true, false, false};
+    }
+
+    const uint32_t elapsed{now - m_phase_start};
+
+    switch (m_phase) {
+        case Phase::off:
+            m_phase = Phase::waiting;
+            m_phase_start = now;
+            break;
+
+        case Phase::waiting:
+            if (elapsed >= m_timing.ignition_delay) {
+                m_statistics.ignitions++;
+                m_ignition_fails = m_faults.no_gas || m_faults.failed_ignitions > 0;
+
+                if (m_faults.failed_ignitions > 0) {
+                    m_faults.failed_ignitions--;
+                }
+
+                m_phase = Phase::igniting;
+                m_phase_start = now;
+            }
+            break;
+
+        case Phase::igniting:
+            if (!m_ignition_fails && elapsed >= m_timing.flame_delay) {
+                m_phase = Phase::running;
+                m_phase_start = now;
+            }
+            else if (elapsed >= m_timing.safety_time) {
+                lock_out(now);
+                return Outputs{true, false, false};
+            }
+            break;
+
+        case Phase::running:
+            if (m_faults.flame_loss_after != 0 && elapsed >= m_faults.flame_loss_after) {
+                m_faults.flame_loss_after = 0;
+                lock_out(now);
+                return Outputs{true, false, false};
+            }
+            break;
+    }
+
+    const bool valve{m_phase == Phase::igniting || m_phase == Phase::running};
+    const bool spark{m_phase == Phase::igniting || (m_phase == Phase::running && now - m_phase_start < m_timing.spark_tail)};
+
+    return Outputs{false, valve, spark};
+}
+
+void BurnerBox::lock_out(uint32_t now)
+{
+    m_statistics.lockouts++;
+    m_locked = true;
+    m_locked_since = now;
+    m_locked_before_start = false;
+    m_phase = Phase::off;
+}
+
+void BurnerBox::reset_released(uint32_t now)
+{
+    if (!m_locked) {
+        return;
+    }
+
+    const bool too_soon{m_reset_attempted && now - m_last_reset_attempt < m_timing.reset_interval};
+    const bool too_young{!m_locked_before_start && now - m_locked_since < m_timing.reset_lock};
+
+    m_reset_attempted = true;
+    m_last_reset_attempt = now;
+
+    if (m_faults.reset_ignored || too_soon || too_young) {
+        m_statistics.resets_rejected++;
+        return;
+    }
+
+    // Restarts the sequence from the off phase on the next update.
+    m_statistics.resets_accepted++;
+    m_locked = false;
+    m_locked_before_start = false;
+}
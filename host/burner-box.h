@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../libs/GasBurnerControl/GasBurnerTiming.h"
+#include <cstdint>
+
+namespace host {
+    /**
+     * Behavioural model of the Satronic 812.2 burner control box with the
+     * FR 870 remote reset, as seen from GasBurnerControl's pins.
+     *
+     * Signals are logical (true = asserted) and independent of the pin
+     * levels, so that the model can be wired to the Arduino shim as well as
+     * to simavr's IRQs. Times are in milliseconds, the defaults are the ones
+     * GasBurnerControl assumes in GasBurnerTiming.h.
+     */
+    class BurnerBox {
+    public:
+        struct Timing {
+            /// From power on or reset to gas valve and spark, when GasBurnerControl first looks.
+            uint32_t ignition_delay{gbc::start_delay * 1000UL};
+            /// From gas valve open to a detected flame, at the latest when the safety time ends.
+            uint32_t flame_delay{gbc::safety_time * 1000UL};
+            /// Without flame after this long the box locks out.
+            uint32_t safety_time{gbc::safety_time * 1000UL};
+            /// Spark keeps running after the flame was detected.
+            uint32_t spark_tail{2000};
+            /// Lockouts younger than this ignore the reset ("approx. 60 s").
+            uint32_t reset_lock{gbc::dejam_delay_1 * 1000UL};
+            /// Minimum time between two reset attempts ("approx. 10 s").
+            uint32_t reset_interval{gbc::dejam_delay_2 * 1000UL};
+            /// Shortest reset press that counts, half of GasBurnerControl's.
+            uint32_t reset_press{gbc::dejam_duration / 2};
+        };
+
+        struct Faults {
+            /// No gas, every ignition fails.
+            bool no_gas{false};
+            /// Number of ignitions failing before one succeeds.
+            unsigned failed_ignitions{0};
+            /// The box is locked out when first powered.
+            bool locked_at_start{false};
+            /// Flame goes out after burning this long once, 0 never.
+            uint32_t flame_loss_after{0};
+            /// The remote reset is broken.
+            bool reset_ignored{false};
+        };
+
+        struct Inputs {
+            bool power;
+            bool reset;
+        };
+
+        struct Outputs {
+            bool jammed;
+            bool valve;
+            bool ignition;
+        };
+
+        struct Statistics {
+            unsigned ignitions{0};
+            unsigned lockouts{0};
+            unsigned resets_accepted{0};
+            unsigned resets_rejected{0};
+        };
+
+        BurnerBox(const Timing& timing, const Faults& faults);
+
+        /**
+         * Advance the model to @p now and return the box's outputs.
+         */
+        Outputs update(uint32_t now, const Inputs& inputs);
+
+        /// @c true while a flame burns.
+        bool burning() const { return m_phase == Phase::running; }
+
+        bool locked() const { return m_locked; }
+
+        const Statistics& statistics() const { return m_statistics; }
+
+    private:
+        enum class Phase {
+            off,
+            waiting,
+            igniting,
+            running,
+        };
+
+        void lock_out(uint32_t now);
+        void reset_released(uint32_t now);
+
+        const Timing m_timing;
+        Faults m_faults;
+        Statistics m_statistics{};
+        Phase m_phase{Phase::off};
+        /// Start of the current phase.
+        uint32_t m_phase_start{0};
+        /// The current ignition will not find a flame.
+        bool m_ignition_fails{false};
+        bool m_locked{false};
+        uint32_t m_locked_since{0};
+        /// Lockouts from before the first power on can be reset right away.
+        bool m_locked_before_start{false};
+        bool m_reset{false};
+        uint32_t m_reset_start{0};
+        bool m_reset_attempted{false};
+        uint32_t m_last_reset_attempt{0};
+    };
+}
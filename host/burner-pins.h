@@ -0,0 +1,26 @@
+#pragma once
+
+#include "arduino/sim.h"
+#include "burner-box.h"
+#include <Arduino.h>
+
+namespace host {
+    /**
+     * Step @p box on GasBurnerControl's pins in the Arduino shim.
+     *
+     * All five signals are active low, as gbc::high is 0. Until begin()
+     * configured them the relay outputs count as released.
+     */
+    inline BurnerBox::Outputs update_burner_box(BurnerBox& box)
+    {
+        const bool power{sim::is_output(GBC_POWER_PIN) && sim::output(GBC_POWER_PIN) == LOW};
+        const bool reset{sim::is_output(GBC_DEJAM_PIN) && sim::output(GBC_DEJAM_PIN) == LOW};
+        const BurnerBox::Outputs outputs{box.update(millis(), BurnerBox::Inputs{power, reset})};
+
+        sim::set_input(GBC_JAMMED_PIN, outputs.jammed ? LOW : HIGH);
+        sim::set_input(GBC_VALVE_PIN, outputs.valve ? LOW : HIGH);
+        sim::set_input(GBC_IGNITION_PIN, outputs.ignition ? LOW : HIGH);
+
+        return outputs;
+    }
+}
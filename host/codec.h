@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../protocol.h"
+#include <cstdint>
+#include <vector>
+
+namespace host {
+    /**
+     * Decoded read_state reply.
+     */
+    struct State {
+        float brew;
+        bool brew_connected;
+        float brew_target;
+        float sparging;
+        bool sparging_connected;
+        float sparging_target;
+        uint8_t burner_state;
+        bool hotplate_on;
+    };
+
+    /**
+     * Frame payload of a request, header set and data of message @p M zeroed.
+     * Fill the data with M's fields at data(request).
+     */
+    template <typename M>
+    std::vector<uint8_t> request(uint8_t address, uint8_t sequence, protocol::Command command)
+    {
+        std::vector<uint8_t> payload(3 + M::size);
+        payload[0] = address;
+        payload[1] = sequence;
+        payload[2] = static_cast<uint8_t>(command);
+        return payload;
+    }
+
+    /**
+     * Frame payload of a request without data.
+     */
+    inline std::vector<uint8_t> request(uint8_t address, uint8_t sequence, protocol::Command command) { return {address, sequence, static_cast<uint8_t>(command)}; }
+
+    /**
+     * Data part of a frame payload.
+     */
+    inline uint8_t* data(std::vector<uint8_t>& payload) { return payload.data() + 3; }
+
+    /**
+     * Return @c true if @p size bytes of frame payload are an ACK carrying message @p M.
+     */
+    template <typename M>
+    bool is_ack(const uint8_t* payload, uint8_t size)
+    {
+        return size == 3 + M::size && (payload[2] & static_cast<uint8_t>(protocol::Response::ack));
+    }
+
+    inline bool decode(const uint8_t* payload, uint8_t size, State& state)
+    {
+        using M = protocol::schema::ReadStateReply;
+
+        if (!is_ack<M>(payload, size)) {
+            return false;
+        }
+
+        const uint8_t* data{payload + 3};
+        state.brew = M::brew::load(data);
+        state.brew_connected = M::brew::is_connected(data);
+        state.brew_target = M::brew_target::load(data);
+        state.sparging = M::sparging::load(data);
+        state.sparging_connected = M::sparging::is_connected(data);
+        state.sparging_target = M::sparging_target::load(data);
+        state.burner_state = M::state::load(data) & 0x3F;
+        state.hotplate_on = M::state::load(data) & 0x80;
+        return true;
+    }
+
+    inline bool decode(const uint8_t* payload, uint8_t size, protocol::Telemetry& telemetry)
+    {
+        using M = protocol::schema::TelemetryPush;
+
+        if (!is_ack<M>(payload, size) || (payload[2] & ~protocol::response_mask) != static_cast<uint8_t>(protocol::Command::telemetry)) {
+            return false;
+        }
+
+        telemetry = M::load(payload + 3);
+        return true;
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * Check that an input trace survives a fast spin of the encoder while the
+ * loop is busy, e.g. flushing the display, and that brewreplay reproduces it.
+ *
+ * The firmware built for Linux enters target entry, gets the knob spun with
+ * no loop pass in between, like during a display transfer, and confirms the
+ * target. The trace it records must not overflow, and brewreplay must end
+ * with the same brew target.
+ */
+#include "../controller.h"
+#include "../sensor.h"
+#include "../trace.h"
+#include "arduino/sim.h"
+#include <Arduino.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+extern MockTemperatureSensor brew_sensor;
+extern MainController controller;
+
+namespace {
+    const char* const event_names[] = {
+#define TRACE_NAME(name, format) #name,
+        TRACE_EVENTS(TRACE_NAME)
+#undef TRACE_NAME
+    };
+
+    /// Microseconds per loop pass, as brewreplay's default.
+    constexpr uint64_t step{100};
+    /// Detents spun without a loop pass.
+    constexpr unsigned detents{12};
+    /// Microseconds between encoder edges, four per detent.
+    constexpr uint64_t edge_interval{1250};
+
+    struct Recorder {
+        std::ofstream csv;
+        unsigned records{0};
+        unsigned overflows{0};
+    };
+
+    /**
+     * Move all trace records to the CSV in brewtrace --record format.
+     */
+    void drain(Recorder& recorder)
+    {
+        trace::Record record;
+
+        while (trace::pop(record)) {
+            recorder.csv << record.time << ',' << event_names[static_cast<uint8_t>(record.event)] << ',' << record.a << ',' << record.b << '\n';
+            recorder.records++;
+
+            if (record.event == trace::Event::overflow) {
+                recorder.overflows++;
+            }
+        }
+    }
+
+    /**
+     * Run loop passes for @p ms milliseconds.
+     */
+    void run(Recorder& recorder, uint64_t ms)
+    {
+        const uint64_t end{sim::now() + ms * 1000};
+
+        while (sim::now() < end) {
+            loop();
+            drain(recorder);
+            sim::advance(step);
+        }
+    }
+
+    /**
+     * Press and release the encoder switch, a press counts on release.
+     */
+    void press(Recorder& recorder)
+    {
+        sim::set_input(KY040_SW, LOW);
+        run(recorder, 100);
+        sim::set_input(KY040_SW, HIGH);
+        run(recorder, 100);
+    }
+
+    /**
+     * Turn the knob clockwise by @p count detents without a loop pass.
+     */
+    void spin(unsigned count)
+    {
+        // Gray code from the resting state, both pulled up.
+        const uint8_t levels[][2] = {{HIGH, LOW}, {LOW, LOW}, {LOW, HIGH}, {HIGH, HIGH}};
+
+        for (unsigned detent = 0; detent < count; detent++) {
+            for (const auto& level : levels) {
+                sim::set_input(KY040_DT, level[0]);
+                sim::set_input(KY040_CLK, level[1]);
+                sim::advance(edge_interval);
+            }
+        }
+    }
+
+    /**
+     * Run brewreplay @p command and return the brew target it ends with.
+     *
+     * @throw std::runtime_error if it fails.
+     */
+    float replay(const std::string& command)
+    {
+        FILE* output{::popen(command.c_str(), "r")};
+
+        if (output == nullptr) {
+            throw std::runtime_error{"cannot run " + command};
+        }
+
+        char line[256];
+        float target{NAN};
+
+        while (fgets(line, sizeof(line), output) != nullptr) {
+            float time, brew, brew_target;
+
+            if (sscanf(line, "%f,%f,%f", &time, &brew, &brew_target) == 3) {
+                target = brew_target;
+            }
+        }
+
+        if (::pclose(output) != 0 || std::isnan(target)) {
+            throw std::runtime_error{command + " failed"};
+        }
+
+        return target;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string self{argv[0]};
+    const auto slash{self.rfind('/')};
+    const std::string replayer{argc > 1 ? std::string{argv[1]} : (slash == std::string::npos ? std::string{"."} : self.substr(0, slash)) + "/brewreplay"};
+    char path[] = "/tmp/input-trace-check-XXXXXX";
+    const int fd{::mkstemp(path)};
+
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+
+    ::close(fd);
+
+    int status{0};
+
+    try {
+        Recorder recorder;
+        recorder.csv.open(path);
+        recorder.csv << "time,event,a,b\n";
+
+        sim::set_speed(0.0);
+        setup();
+        brew_sensor.set(20.0f, true);
+
+        run(recorder, 1000);
+        press(recorder);
+        spin(detents);
+        run(recorder, 100);
+        press(recorder);
+        run(recorder, 1000);
+        recorder.csv.close();
+
+        const float target{controller.brew_target_temperature()};
+        const float replayed{replay(replayer + " --csv " + path)};
+
+        printf("%u detents spun without a loop pass, %u records, %u overflows\n", detents, recorder.records, recorder.overflows);
+        printf("brew target %.1f recorded, %.1f replayed\n", target, replayed);
+
+        if (recorder.overflows != 0 || target <= 20.0f || replayed != target) {
+            fprintf(stderr, "FAIL\n");
+            status = 1;
+        }
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        status = 1;
+    }
+
+    ::unlink(path);
+    return status;
+}
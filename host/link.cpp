@@ -0,0 +1,201 @@
+#include "link.h"
+#include <asm/termbits.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+    std::system_error os_error(const std::string& what)
+    {
+        return std::system_error{errno, std::generic_category(), what};
+    }
+
+    /**
+     * Put @p fd into raw 8N1 mode at @p baud_rate.
+     *
+     * Uses the Linux termios2 interface, which takes the rate as number with
+     * BOTHER, since glibc has no B constant for rates like 250000.
+     */
+    void make_raw(int fd, uint32_t baud_rate)
+    {
+        termios2 tty;
+
+        if (::ioctl(fd, TCGETS2, &tty) < 0) {
+            throw os_error("TCGETS2");
+        }
+
+        // What cfmakeraw() does.
+        tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+        tty.c_oflag &= ~OPOST;
+        tty.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+        tty.c_cflag &= ~(CSIZE | PARENB | CBAUD | (CBAUD << IBSHIFT));
+        tty.c_cflag |= CS8 | CLOCAL | CREAD | BOTHER | (BOTHER << IBSHIFT);
+        tty.c_cc[VMIN] = 1;
+        tty.c_cc[VTIME] = 0;
+        tty.c_ispeed = baud_rate;
+        tty.c_ospeed = baud_rate;
+
+        if (::ioctl(fd, TCSETS2, &tty) < 0) {
+            throw os_error("TCSETS2");
+        }
+    }
+
+    int connect_unix(const std::string& path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument{"socket path too long"};
+        }
+
+        strcpy(address.sun_path, path.c_str());
+        const int fd{::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+
+        if (fd < 0) {
+            throw os_error(path);
+        }
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            const auto error{os_error(path)};
+            ::close(fd);
+            throw error;
+        }
+
+        return fd;
+    }
+}
+
+int host::open_serial(const std::string& path, uint32_t baud_rate)
+{
+    if (baud_rate == 0) {
+        throw std::invalid_argument{"unsupported baud rate 0"};
+    }
+
+    const int fd{::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)};
+
+    if (fd < 0) {
+        throw os_error(path);
+    }
+
+    try {
+        make_raw(fd, baud_rate);
+    }
+    catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    return fd;
+}
+
+int host::open_link(const std::string& path, uint32_t baud_rate)
+{
+    struct stat info;
+
+    if (::stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        return connect_unix(path);
+    }
+
+    return open_serial(path, baud_rate);
+}
+
+int host::open_pty(std::string& name)
+{
+    const int fd{posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)};
+
+    if (fd < 0) {
+        throw os_error("posix_openpt");
+    }
+
+    try {
+        if (grantpt(fd) < 0 || unlockpt(fd) < 0) {
+            throw os_error("unlockpt");
+        }
+
+        make_raw(fd, 115200);
+        name = ptsname(fd);
+    }
+    catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    return fd;
+}
+
+host::FrameStream::FrameStream(int fd)
+: m_fd{fd}
+{
+}
+
+host::FrameStream::~FrameStream()
+{
+    ::close(m_fd);
+}
+
+bool host::FrameStream::send(const uint8_t* payload, size_t size)
+{
+    if (size > frame::max_size - 2) {
+        return false;
+    }
+
+    uint8_t encoded[frame::max_encoded_size];
+    const size_t length{frame::encode(payload, size, encoded)};
+    m_out.insert(m_out.end(), encoded, encoded + length);
+
+    return m_out.size() <= max_pending && flush();
+}
+
+bool host::FrameStream::flush()
+{
+    while (!m_out.empty()) {
+        const ssize_t written{::write(m_fd, m_out.data(), m_out.size())};
+
+        if (written < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        m_out.erase(m_out.begin(), m_out.begin() + written);
+    }
+
+    return true;
+}
+
+bool host::FrameStream::receive(const FrameHandler& on_frame)
+{
+    uint8_t buffer[256];
+
+    while (true) {
+        const ssize_t count{::read(m_fd, buffer, sizeof(buffer))};
+
+        if (count == 0) {
+            return false;
+        }
+
+        if (count < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        for (ssize_t i = 0; i < count; i++) {
+            switch (m_decoder.feed(buffer[i])) {
+                case frame::Decoder::Result::frame:
+                    on_frame(m_decoder.data(), m_decoder.size());
+                    break;
+                case frame::Decoder::Result::error:
+                    m_errors++;
+                    break;
+                case frame::Decoder::Result::none:
+                    break;
+            }
+        }
+    }
+}
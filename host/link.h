@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../frame.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace host {
+    /**
+     * Open @p path (serial device or PTY) in raw non-blocking mode.
+     *
+     * Any @p baud_rate is requested from the driver, including 250000 which
+     * has no termios constant.
+     *
+     * @throw std::system_error if the device cannot be opened or configured,
+     * e.g. because the driver rejects the rate.
+     * @throw std::invalid_argument if @p baud_rate is 0.
+     */
+    int open_serial(const std::string& path, uint32_t baud_rate);
+
+    /**
+     * Connect to brewproxy if @p path is a Unix socket, otherwise open it as
+     * serial device.
+     *
+     * @throw std::system_error if neither works.
+     */
+    int open_link(const std::string& path, uint32_t baud_rate);
+
+    /**
+     * Create a PTY pair in raw mode and return the master side, the slave
+     * device name is written to @p name.
+     *
+     * @throw std::system_error if no PTY is available.
+     */
+    int open_pty(std::string& name);
+
+    /**
+     * Non-blocking frame connection over a file descriptor.
+     *
+     * Outgoing frames are buffered so that a slow peer never blocks the
+     * caller; poll for POLLOUT while wants_write() and call flush().
+     */
+    class FrameStream {
+    public:
+        using FrameHandler = std::function<void(const uint8_t* data, uint8_t size)>;
+
+        /// Peers with more unsent data than this are considered dead.
+        static constexpr size_t max_pending{64 * 1024};
+
+        /**
+         * Take ownership of @p fd, which is closed on destruction.
+         */
+        explicit FrameStream(int fd);
+        ~FrameStream();
+
+        FrameStream(const FrameStream&) = delete;
+        FrameStream& operator=(const FrameStream&) = delete;
+
+        int fd() const { return m_fd; }
+
+        /**
+         * Encode and queue a frame.
+         *
+         * @return @c false if the peer is gone or too far behind.
+         */
+        bool send(const uint8_t* payload, size_t size);
+
+        bool send(const std::vector<uint8_t>& payload) { return send(payload.data(), payload.size()); }
+
+        /**
+         * Write as much buffered data as the peer accepts.
+         *
+         * @return @c false if the peer is gone.
+         */
+        bool flush();
+
+        bool wants_write() const { return !m_out.empty(); }
+
+        /**
+         * Read available bytes and call @p on_frame for each valid frame.
+         *
+         * @return @c false on end of file or error.
+         */
+        bool receive(const FrameHandler& on_frame);
+
+        /// Number of corrupt frames received so far.
+        unsigned long errors() const { return m_errors; }
+
+    private:
+        int m_fd;
+        frame::Decoder m_decoder{};
+        std::vector<uint8_t> m_out;
+        unsigned long m_errors{0};
+    };
+}
@@ -0,0 +1,196 @@
+#include "plant.h"
+
+using host::Kettle;
+using host::Metrics;
+using host::PlantBurner;
+using host::PlantHotplate;
+using host::PlantSensor;
+
+namespace {
+    /// Specific heat capacity of water in J/(kg K), a litre weighs a kilogram.
+    constexpr float water_capacity{4186.0f};
+    /// DS18B20 conversion time at 12 bits in milliseconds.
+    constexpr Clock::Time conversion_time{750};
+    /// Start delay of GasBurnerControl in milliseconds.
+    constexpr Clock::Time start_delay{2000};
+
+    /// First-order lag step, exact for any @p dt.
+    float follow(float value, float target, float dt, float tau)
+    {
+        return tau > 0.0f ? target + (value - target) * expf(-dt / tau) : target;
+    }
+}
+
+Kettle::Kettle(const Parameters& parameters)
+: m_parameters{parameters}
+, m_temperature{parameters.initial}
+, m_probe{parameters.initial}
+{
+}
+
+void Kettle::advance(float dt, bool heating)
+{
+    const float capacity{m_parameters.volume * water_capacity};
+
+    m_heat = follow(m_heat, heating ? m_parameters.power : 0.0f, dt, m_parameters.heat_lag);
+    m_temperature += (m_heat - m_parameters.loss * (m_temperature - m_parameters.ambient)) * dt / capacity;
+    m_probe = follow(m_probe, m_temperature, dt, m_parameters.probe_lag);
+}
+
+PlantSensor::PlantSensor(const Kettle& kettle, float resolution)
+: m_kettle{kettle}
+, m_resolution{resolution}
+{
+}
+
+void PlantSensor::begin()
+{
+    m_temperature = roundf(m_kettle.probe() / m_resolution) * m_resolution;
+    m_last_conversion = Clock::now();
+}
+
+void PlantSensor::update()
+{
+    if (Clock::since(m_last_conversion) >= conversion_time) {
+        m_temperature = roundf(m_kettle.probe() / m_resolution) * m_resolution;
+        m_last_conversion = Clock::now();
+    }
+}
+
+float PlantSensor::temperature()
+{
+    return m_temperature;
+}
+
+unsigned int PlantSensor::last_seen()
+{
+    return Clock::since(m_last_conversion);
+}
+
+bool PlantSensor::is_connected()
+{
+    return true;
+}
+
+PlantBurner::PlantBurner(Clock::Time dead_time)
+: m_dead_time{dead_time}
+{
+}
+
+void PlantBurner::begin()
+{
+    stop();
+}
+
+void PlantBurner::start()
+{
+    m_state = State::starting;
+    m_start_time = Clock::now();
+}
+
+void PlantBurner::stop()
+{
+    m_state = State::idle;
+}
+
+void PlantBurner::update()
+{
+    const auto elapsed{Clock::since(m_start_time)};
+
+    if (m_state == State::starting && elapsed >= start_delay) {
+        m_state = State::ignition;
+    }
+
+    if (m_state == State::ignition && elapsed >= m_dead_time) {
+        m_state = State::running;
+    }
+}
+
+GasBurner::State PlantBurner::state()
+{
+    return m_state;
+}
+
+uint16_t PlantBurner::full_state()
+{
+    return GasBurner::encode_state(m_state, 0, m_state == State::ignition ? 1 : 0);
+}
+
+void PlantHotplate::begin()
+{
+    m_on = false;
+}
+
+void PlantHotplate::start()
+{
+    m_on = true;
+}
+
+void PlantHotplate::stop()
+{
+    m_on = false;
+}
+
+bool PlantHotplate::state()
+{
+    return m_on;
+}
+
+Metrics::Metrics(float band)
+: m_band{band}
+{
+}
+
+void Metrics::update(Clock::Time now, float target, float temperature, bool heater_on)
+{
+    if (m_heater_on) {
+        m_on_time += now - m_last_update;
+    }
+
+    if (heater_on && !m_heater_on) {
+        m_cycles++;
+    }
+
+    m_heater_on = heater_on;
+    m_last_update = now;
+
+    if (target != m_target) {
+        m_target = target;
+        m_target_time = now;
+        m_last_outside = now;
+        m_risen = false;
+        m_reached = false;
+        m_overshoot = 0.0f;
+    }
+
+    if (target == 0.0f) {
+        m_inside = false;
+        return;
+    }
+
+    m_inside = fabsf(temperature - target) <= m_band;
+
+    if (!m_inside) {
+        m_last_outside = now;
+    }
+    else if (!m_risen) {
+        m_risen = true;
+        m_rise_time = now;
+    }
+
+    m_reached = m_reached || temperature >= target;
+
+    if (m_reached) {
+        m_overshoot = max(m_overshoot, temperature - target);
+    }
+}
+
+float Metrics::rise_time() const
+{
+    return m_risen ? (m_rise_time - m_target_time) / 1000.0f : -1.0f;
+}
+
+float Metrics::settling_time() const
+{
+    return m_inside ? (m_last_outside - m_target_time) / 1000.0f : -1.0f;
+}
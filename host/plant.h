@@ -0,0 +1,164 @@
+#pragma once
+
+#include "burner.h"
+#include "clock.h"
+#include "hotplate.h"
+#include "sensor.h"
+#include <Arduino.h>
+
+namespace host {
+    /**
+     * Lumped-capacity model of a kettle of water heated by a burner or
+     * hotplate and losing heat to its surroundings.
+     *
+     * Heat reaches the water through a first-order lag (flame to kettle
+     * bottom, hot plate) and the DS18B20 probe follows the water with its own
+     * time constant.
+     */
+    class Kettle {
+    public:
+        struct Parameters {
+            /// Water volume in litres.
+            float volume{50.0f};
+            /// Heater power reaching the water in W.
+            float power{10000.0f};
+            /// Heat loss to the ambient in W/K.
+            float loss{10.0f};
+            float ambient{20.0f};
+            /// Initial water temperature in degree Celsius.
+            float initial{20.0f};
+            /// Time constant of the heat flow in s.
+            float heat_lag{30.0f};
+            /// Time constant of the temperature probe in s.
+            float probe_lag{10.0f};
+        };
+
+        explicit Kettle(const Parameters& parameters);
+
+        /**
+         * Advance the model by @p dt seconds with the heater on or off.
+         */
+        void advance(float dt, bool heating);
+
+        /// Water temperature in degree Celsius.
+        float temperature() const { return m_temperature; }
+
+        /// Temperature of the probe tip in degree Celsius.
+        float probe() const { return m_probe; }
+
+        const Parameters& parameters() const { return m_parameters; }
+
+    private:
+        const Parameters m_parameters;
+        float m_temperature;
+        float m_probe;
+        /// Heat currently flowing into the water in W.
+        float m_heat{0.0f};
+    };
+
+    /**
+     * DS18B20 on a kettle: 12-bit readings, a new one every 750 ms.
+     */
+    class PlantSensor : public TemperatureSensor {
+    public:
+        /**
+         * @param resolution Quantization step in degree Celsius.
+         */
+        PlantSensor(const Kettle& kettle, float resolution = 0.0625f);
+
+        void begin() final;
+        void update() final;
+        float temperature() final;
+        unsigned int last_seen() final;
+        bool is_connected() final;
+
+    private:
+        const Kettle& m_kettle;
+        const float m_resolution;
+        float m_temperature{0.0f};
+        Clock::Time m_last_conversion{0};
+    };
+
+    /**
+     * Gas burner going through start delay and ignition like
+     * GasBurnerControl before it reports running and heat flows.
+     */
+    class PlantBurner : public GasBurner {
+    public:
+        /**
+         * @param dead_time Time in milliseconds from start() to running.
+         */
+        explicit PlantBurner(Clock::Time dead_time = 24000);
+
+        void begin() final;
+        void start() final;
+        void stop() final;
+        void update() final;
+        State state() final;
+        uint16_t full_state() final;
+
+        bool heating() const { return m_state == State::running; }
+
+    private:
+        const Clock::Time m_dead_time;
+        State m_state{State::idle};
+        Clock::Time m_start_time{0};
+    };
+
+    class PlantHotplate : public Hotplate {
+    public:
+        void begin() final;
+        void start() final;
+        void stop() final;
+        bool state() final;
+
+        bool heating() const { return m_on; }
+
+    private:
+        bool m_on{false};
+    };
+
+    /**
+     * Step response metrics of one channel, restarted on every target change.
+     */
+    class Metrics {
+    public:
+        /**
+         * @param band Half-width in degree Celsius of the band around the
+         * target that counts as settled.
+         */
+        explicit Metrics(float band = 0.5f);
+
+        void update(Clock::Time now, float target, float temperature, bool heater_on);
+
+        /// Seconds from the target change until the temperature entered the band, negative if it did not.
+        float rise_time() const;
+
+        /// Seconds from the target change until the temperature stayed in the band, negative if it did not.
+        float settling_time() const;
+
+        /// Largest excess over the target in degree Celsius once reached.
+        float overshoot() const { return m_overshoot; }
+
+        /// Number of times the heater was switched on.
+        unsigned cycles() const { return m_cycles; }
+
+        /// Seconds the heater was on.
+        float on_time() const { return m_on_time / 1000.0f; }
+
+    private:
+        const float m_band;
+        float m_target{0.0f};
+        Clock::Time m_target_time{0};
+        Clock::Time m_last_outside{0};
+        Clock::Time m_rise_time{0};
+        Clock::Time m_last_update{0};
+        bool m_inside{false};
+        bool m_risen{false};
+        bool m_reached{false};
+        bool m_heater_on{false};
+        float m_overshoot{0.0f};
+        unsigned m_cycles{0};
+        unsigned long m_on_time{0};
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * Configuration of the brewslave-sim build, force-included instead of the
+ * config.h written by configure. Pins follow config.ini.template, sensors
+ * are mocks and GasBurnerControl drives the emulated box in burner-box.h.
+ */
+#define VERSION_STRING "sim"
+
+#define WITH_TRACE 1
+#define WITH_INPUT_TRACE 1
+#define WITH_TIMING 1
+
+#define WITH_SH1106 1
+#define SH1106_RST 12
+#define SH1106_DC 10
+#define SH1106_DIN 11
+#define SH1106_CLK 13
+
+#define WITH_KY040 1
+#define KY040_SW A0
+#define KY040_DT A1
+#define KY040_CLK A2
+#define KY040_ACCELERATION 5
+#define KY040_ACCELERATION_SLOW 100
+#define KY040_ACCELERATION_FAST 10
+
+#define WITH_BUTTONS 1
+#define BREW_BUTTON_PIN 2
+#define SPARGING_BUTTON_PIN 3
+
+#define WITH_GBC 1
+#define GBC_POWER_PIN 6
+#define GBC_DEJAM_PIN 4
+#define GBC_JAMMED_PIN A3
+#define GBC_VALVE_PIN A4
+#define GBC_IGNITION_PIN A5
+
+#define HOTPLATE_PIN 5
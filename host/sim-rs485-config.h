@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * Configuration of the brewslave-rs485 build for brewbus: the brewslave-sim
+ * firmware as RS-485 node. Static initialization constructs Comm before
+ * main() runs, so the address comes from the environment.
+ */
+#include "sim-config.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define WITH_RS485 1
+#define RS485_DE_PIN 7
+#define RS485_ADDRESS sim_rs485_address()
+
+/**
+ * Return the node address in BREWSLAVE_ADDRESS, 1 if unset.
+ */
+inline uint8_t sim_rs485_address()
+{
+    const char* address{getenv("BREWSLAVE_ADDRESS")};
+    return address ? static_cast<uint8_t>(atoi(address)) : 1;
+}
@@ -0,0 +1,44 @@
+#include "input.h"
+#include "input_trace.h"
+
+namespace {
+    static_assert((input::capacity & (input::capacity - 1)) == 0, "indices wrap at 256");
+
+    input::Event buffer[input::capacity];
+    /// Free-running, written by the consumer only.
+    volatile uint8_t head{0};
+    /// Free-running, written by the producer only.
+    volatile uint8_t tail{0};
+
+    /// Keeps the compiler from moving buffer accesses across index updates.
+    inline void barrier() { __asm__ __volatile__("" ::: "memory"); }
+}
+
+void input::push(Source source, int8_t steps)
+{
+    const uint8_t end{tail};
+
+    if (static_cast<uint8_t>(end - head) == capacity) {
+        return;
+    }
+
+    buffer[end % capacity] = Event{Clock::now(), source, steps};
+    barrier();
+    tail = end + 1;
+    INPUT_TRACE_EVENT(source, steps);
+}
+
+bool input::pop(Event& event)
+{
+    const uint8_t start{head};
+
+    if (start == tail) {
+        return false;
+    }
+
+    barrier();
+    event = buffer[start % capacity];
+    barrier();
+    head = start + 1;
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "clock.h"
+#include <Arduino.h>
+
+/**
+ * Queue of timestamped user input events from the encoder and button
+ * interrupts to the main loop.
+ *
+ * Interrupt handlers push and App pops everything queued on every UI pass,
+ * so no detent is lost while the loop is busy, e.g. flushing the display.
+ * AVR interrupt handlers never nest, so all of them together are the single
+ * producer and the loop the single consumer. Each side writes only its own
+ * u8 index, which is atomic, so neither masks interrupts. If more than
+ * capacity events pile up the newest are dropped.
+ */
+namespace input {
+    enum class Source : uint8_t {
+        encoder,
+        encoder_switch,
+        brew_button,
+        sparging_button,
+    };
+
+    struct Event {
+        Clock::Time time;
+        Source source;
+        /// Detents turned, positive clockwise, encoder events only.
+        int8_t steps;
+    };
+
+    /// Number of events kept until popped, a power of two.
+    constexpr uint8_t capacity{16};
+
+    /**
+     * Queue an event of @p source at the current time, interrupts only.
+     */
+    void push(Source source, int8_t steps = 0);
+
+    /**
+     * Remove the oldest event, main loop only.
+     *
+     * @return @c false if there is none.
+     */
+    bool pop(Event& event);
+}
@@ -0,0 +1,114 @@
+#include "input_trace.h"
+
+namespace {
+    const uint8_t pins[] = {
+#if defined(BREW_BUTTON_PIN)
+        BREW_BUTTON_PIN,
+#else
+        input_trace::no_pin,
+#endif
+#if defined(SPARGING_BUTTON_PIN)
+        SPARGING_BUTTON_PIN,
+#else
+        input_trace::no_pin,
+#endif
+#if defined(WITH_GBC)
+        GBC_JAMMED_PIN,
+        GBC_VALVE_PIN,
+        GBC_IGNITION_PIN,
+#else
+        input_trace::no_pin,
+        input_trace::no_pin,
+        input_trace::no_pin,
+#endif
+    };
+
+    static_assert(sizeof(pins) == static_cast<uint8_t>(input_trace::Input::count), "pin for every input");
+}
+
+uint8_t input_trace::pin(Input input)
+{
+    return pins[static_cast<uint8_t>(input)];
+}
+
+#if defined(WITH_INPUT_TRACE)
+namespace {
+    /**
+     * Input register and bit of every pin, looked up once like Ky040 does,
+     * so that record_pins() only reads registers on every loop pass.
+     */
+    struct Ports {
+        Ports()
+        {
+            for (uint8_t i = 0; i < sizeof(pins); i++) {
+                if (pins[i] != input_trace::no_pin) {
+                    registers[i] = portInputRegister(digitalPinToPort(pins[i]));
+                    masks[i] = digitalPinToBitMask(pins[i]);
+                    present |= 1 << i;
+                }
+            }
+        }
+
+        volatile uint8_t* registers[sizeof(pins)]{};
+        uint8_t masks[sizeof(pins)]{};
+        uint16_t present{0};
+    };
+
+    const Ports ports;
+
+    uint16_t last_levels{0};
+    bool pins_recorded{false};
+
+    struct Reading {
+        int16_t sixteenths;
+        bool connected;
+        bool recorded;
+    };
+
+    Reading readings[2];
+}
+
+void input_trace::record_pins()
+{
+    uint16_t levels{0};
+
+    for (uint8_t i = 0; i < sizeof(pins); i++) {
+        if (ports.present & (1 << i)) {
+            levels |= (*ports.registers[i] & ports.masks[i]) ? 1 << i : 0;
+        }
+    }
+
+    // The first record carries the complete initial state.
+    const uint16_t changed{pins_recorded ? static_cast<uint16_t>(levels ^ last_levels) : ports.present};
+
+    if (changed != 0) {
+        TRACE(input_pins, levels, changed);
+        last_levels = levels;
+        pins_recorded = true;
+    }
+}
+
+void input_trace::record_event(uint8_t source, int8_t steps)
+{
+    TRACE(input_event, source, static_cast<uint16_t>(static_cast<int16_t>(steps)));
+}
+
+void input_trace::record_sensor(uint8_t channel, TemperatureSensor& sensor)
+{
+    Reading& last{readings[channel]};
+    const Reading reading{static_cast<int16_t>(round(sensor.temperature() * 16.0f)), sensor.is_connected(), true};
+
+    if (!last.recorded || reading.sixteenths != last.sixteenths || reading.connected != last.connected) {
+        const uint16_t value{static_cast<uint16_t>(reading.sixteenths)};
+
+        if (channel == 0) {
+            TRACE(input_brew_sensor, value, reading.connected);
+        }
+        else {
+            TRACE(input_sparging_sensor, value, reading.connected);
+        }
+
+        last = reading;
+    }
+}
+#endif // WITH_INPUT_TRACE
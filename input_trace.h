@@ -0,0 +1,68 @@
+#pragma once
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+#include "sensor.h"
+#include "trace.h"
+#include <Arduino.h>
+
+/**
+ * Record of everything App, Ui and MainController read from the outside
+ * world into the trace channel, replayed by host/brewreplay.
+ *
+ * Encoder and button interrupts are recorded as the decoded events
+ * input::push() queues, one record per detent or press, so a fast spin
+ * while the loop is busy takes no more records than the input queue holds.
+ * The levels of the pins the loop itself reads are sampled once per pass and
+ * recorded by role, so a trace replays on a build with other pin numbers.
+ * Temperatures are recorded in 1/16 degree Celsius, the DS18B20 resolution,
+ * so they replay exactly.
+ *
+ * Without WITH_INPUT_TRACE the INPUT_TRACE_*() macros compile to nothing.
+ */
+namespace input_trace {
+    /// Bit of an input_pins record.
+    enum class Input : uint8_t {
+        brew_button,
+        sparging_button,
+        gbc_jammed,
+        gbc_valve,
+        gbc_ignition,
+        count,
+    };
+
+    /// Pin of an input this build does not have.
+    constexpr uint8_t no_pin{0xFF};
+
+    /**
+     * Pin of @p input in this build or no_pin.
+     */
+    uint8_t pin(Input input);
+
+    /**
+     * Sample all input pins and record those that changed, main loop only.
+     */
+    void record_pins();
+
+    /**
+     * Record an event of @p source that input::push() queued.
+     */
+    void record_event(uint8_t source, int8_t steps);
+
+    /**
+     * Record the reading of @p sensor of @p channel (see Controller::Channel)
+     * if it changed.
+     */
+    void record_sensor(uint8_t channel, TemperatureSensor& sensor);
+}
+
+#if defined(WITH_INPUT_TRACE)
+#define INPUT_TRACE_PINS() input_trace::record_pins()
+#define INPUT_TRACE_EVENT(source, steps) input_trace::record_event(static_cast<uint8_t>(source), steps)
+#define INPUT_TRACE_SENSOR(channel, sensor) input_trace::record_sensor(static_cast<uint8_t>(channel), sensor)
+#else
+#define INPUT_TRACE_PINS()
+#define INPUT_TRACE_EVENT(source, steps)
+#define INPUT_TRACE_SENSOR(channel, sensor)
+#endif
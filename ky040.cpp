@@ -1,10 +1,14 @@
 #include "ky040.h"
+#include "input.h"
 
-Ky040::Ky040(uint8_t sw, uint8_t dt, uint8_t clk)
-: m_sw_pin{sw}
+Ky040::Ky040(uint8_t sw, uint8_t dt, uint8_t clk, Acceleration acceleration)
+: m_sw_port{portInputRegister(digitalPinToPort(sw))}
+, m_sw_mask{digitalPinToBitMask(sw)}
 , m_encoder{dt, clk}
+, m_acceleration{acceleration}
 {
     pinMode(sw, INPUT_PULLUP);
+    m_sw = (*m_sw_port & m_sw_mask) ? 1 : 0;
 
     pin_change(sw);
     pin_change(dt);
@@ -13,31 +17,20 @@ Ky040::Ky040(uint8_t sw, uint8_t dt, uint8_t clk)
 
 void Ky040::update()
 {
-    const auto sw{digitalRead(m_sw_pin)};
-    m_pressed = m_pressed || ((m_sw != sw) && (sw == 1));
+    const uint8_t sw{(*m_sw_port & m_sw_mask) ? uint8_t{1} : uint8_t{0}};
+
+    // The switch pulls low, a press counts on release.
+    if (sw != m_sw && sw == 1) {
+        input::push(input::Source::encoder_switch);
+    }
+
     m_sw = sw;
-    m_encoder.tick();
-}
 
-ButtonEncoder::Direction Ky040::direction()
-{
-    switch (m_encoder.getDirection()) {
-        case RotaryEncoder::Direction::CLOCKWISE:
-            return ButtonEncoder::Direction::Clockwise;
-        case RotaryEncoder::Direction::COUNTERCLOCKWISE:
-            return ButtonEncoder::Direction::CounterClockwise;
-        case RotaryEncoder::Direction::NOROTATION:
-            return ButtonEncoder::Direction::None;
-    };
-
-    return ButtonEncoder::Direction::None;
-}
+    const int8_t steps{m_encoder.tick()};
 
-bool Ky040::pressed()
-{
-    const auto tmp{m_pressed};
-    m_pressed = false;
-    return tmp;
+    if (steps != 0) {
+        input::push(input::Source::encoder, accelerate(steps));
+    }
 }
 
 void Ky040::pin_change(uint8_t pin)
@@ -46,3 +39,30 @@ void Ky040::pin_change(uint8_t pin)
     PCIFR |= bit(digitalPinToPCICRbit(pin));
     PCICR |= bit(digitalPinToPCICRbit(pin));
 }
+
+int8_t Ky040::accelerate(int8_t steps)
+{
+    const Clock::Time now{Clock::now()};
+    const Clock::Time interval{now - m_last_step};
+    const int8_t direction{static_cast<int8_t>(steps > 0 ? 1 : -1)};
+    const Acceleration& curve{m_acceleration};
+
+    m_last_step = now;
+
+    // Turning back is always fine control.
+    if (direction != m_last_direction || interval >= curve.slow || curve.max <= 1) {
+        m_last_direction = direction;
+        return steps;
+    }
+
+    // Below slow, so 16-bit arithmetic suffices in the interrupt.
+    const uint8_t elapsed{static_cast<uint8_t>(interval)};
+    uint8_t factor{curve.max};
+
+    if (elapsed > curve.fast) {
+        // Linear from 1 at slow to max at fast.
+        factor = 1 + static_cast<uint16_t>(curve.max - 1) * (curve.slow - elapsed) / (curve.slow - curve.fast);
+    }
+
+    return static_cast<int8_t>(constrain(steps * factor, -127, 127));
+}
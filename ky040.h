@@ -1,23 +1,39 @@
 #pragma once
 
 #include "RotaryEncoder.h"
+#include "clock.h"
 #include "encoder.h"
 
 class Ky040 : public ButtonEncoder {
 public:
-    Ky040(uint8_t sw, uint8_t dt, uint8_t clk);
+    /**
+     * Acceleration curve, detents turned faster than one per @p slow
+     * milliseconds count more, up to @p max at one per @p fast milliseconds.
+     * A @p max of 1 disables acceleration.
+     */
+    struct Acceleration {
+        uint8_t max;
+        uint8_t slow;
+        uint8_t fast;
+    };
 
-    void update() final;
-
-    ButtonEncoder::Direction direction() final;
+    Ky040(uint8_t sw, uint8_t dt, uint8_t clk, Acceleration acceleration = Acceleration{1, 100, 10});
 
-    bool pressed() final;
+    void update() final;
 
 private:
     void pin_change(uint8_t pin);
 
+    /**
+     * Scale @p steps by the rate the knob turns at.
+     */
+    int8_t accelerate(int8_t steps);
+
     uint8_t m_sw{0};
-    uint8_t m_sw_pin;
-    bool m_pressed{false};
+    volatile uint8_t* m_sw_port;
+    uint8_t m_sw_mask;
     RotaryEncoder m_encoder;
+    Acceleration m_acceleration;
+    Clock::Time m_last_step{0};
+    int8_t m_last_direction{0};
 };
@@ -1,30 +1,12 @@
 #include "GasBurnerControl.h"
-
-#ifdef GBC_SERIAL_DEBUG
-#define GBC_DEBUG(x) Serial.print((x))
-#define GBC_DEBUGLN(x) Serial.println((x))
-#else
-#define GBC_DEBUG(x)
-#define GBC_DEBUGLN(x)
-#endif
+#include "GasBurnerTiming.h"
+#include "trace.h"
 
 namespace gbc {
     /// Number of unsuccessful dejam attempts before aborting permanently.
     constexpr uint8_t num_dejam_attempts{3};
     /// Number of unsuccessful ignition attempts before aborting permanently.
     constexpr uint8_t num_ignition_attempts{3};
-    /// Initial delay in seconds after powering the GBC.
-    constexpr uint8_t start_delay{2};
-    /// Wait time in seconds until dejamming is possible.
-    constexpr uint8_t dejam_delay_1{60};
-    /// Wait time in seconds between additional dejam attempts.
-    constexpr uint8_t dejam_delay_2{10};
-    /// Time in seconds after which ignition should be complete.
-    constexpr uint8_t ignition_duration{22};
-    /// Duration of button press in milliseconds during dejamming.
-    constexpr uint16_t dejam_duration{1000};
-    /// Delay after dejam button release in milliseconds.
-    constexpr uint16_t post_dejam_delay{1000};
 
     constexpr int high{0};
     constexpr int low{1};
@@ -57,83 +39,69 @@ void GasBurnerControl::begin()
     pinMode(m_valve_pin, INPUT);
     pinMode(m_ignition_pin, INPUT);
 
-    GBC_DEBUGLN(gbc::start_delay);
-
     stop();
 }
 
 void GasBurnerControl::dejam(unsigned int delay_s)
 {
-    GBC_DEBUG(F("|-Burner::_dejam("));
-    GBC_DEBUG(delay_s);
-    GBC_DEBUG(F("   "));
-    GBC_DEBUG(m_dejam_counter);
-    GBC_DEBUGLN(F(")"));
-
-    if (m_next_dejam_attempt_time == 0) {
-        m_next_dejam_attempt_time = millis() + delay_s * 1000;
-        GBC_DEBUG(F("|--Set next dejam attempt time to "));
-        GBC_DEBUG(m_next_dejam_attempt_time / 1000);
-        GBC_DEBUGLN(F(" s"));
+    if (m_state == GasBurner::State::dejam_start) {
+        m_dejam_timer = Clock::now();
+        TRACE(gbc_dejam_scheduled, delay_s, m_dejam_counter);
         m_state = GasBurner::State::dejam_pre_delay;
     }
 
-    if (millis() >= m_next_dejam_attempt_time) {
-        GBC_DEBUGLN(F("|--Dejamming now"));
-        bool dejamRead = digitalRead(m_dejam_pin);
-        if ((dejamRead == gbc::low) & (m_dejam_timer == 0)) {
-            GBC_DEBUGLN(F("|---Press dejam button now"));
-            digitalWrite(m_dejam_pin, gbc::high); // press dejam button
-            m_dejam_timer = millis();
-            m_state = GasBurner::State::dejam_button_pressed;
-        }
-        else if (dejamRead == gbc::high) {
-            if (millis() - m_dejam_timer >= gbc::dejam_duration) {
-                GBC_DEBUGLN(F("|---Release dejam button now"));
+    // Every phase is timed from its own start, which survives a wraparound.
+    const auto elapsed{Clock::since(m_dejam_timer)};
+    const bool dejamRead = digitalRead(m_dejam_pin);
+    const bool expected = m_state == GasBurner::State::dejam_button_pressed ? gbc::high : gbc::low;
+
+    if (dejamRead != expected) {
+        TRACE(gbc_dejam_error, dejamRead);
+        // something went wrong
+        m_state = GasBurner::State::error_other;
+        return;
+    }
+
+    switch (m_state) {
+        case GasBurner::State::dejam_pre_delay:
+            if (elapsed >= delay_s * 1000UL) {
+                TRACE(gbc_dejam_press, m_dejam_counter);
+                digitalWrite(m_dejam_pin, gbc::high); // press dejam button
+                m_dejam_timer = Clock::now();
+                m_state = GasBurner::State::dejam_button_pressed;
+            }
+            break;
+
+        case GasBurner::State::dejam_button_pressed:
+            if (elapsed >= gbc::dejam_duration) {
+                TRACE(gbc_dejam_release, m_dejam_counter);
                 digitalWrite(m_dejam_pin, gbc::low);
-                m_dejam_timer = millis();
+                m_dejam_timer = Clock::now();
                 m_state = GasBurner::State::dejam_post_delay;
             }
-            else {
-                // wait for dejam press duration to pass
-                GBC_DEBUGLN(F("|---Wait for dejam button release"));
-            }
-        }
-        else if ((dejamRead == gbc::low) & (m_dejam_timer > 0)) {
-            GBC_DEBUGLN(F("|---Post dejam delay"));
-            if (millis() - m_dejam_timer >= gbc::post_dejam_delay) {
-                // dejam should be completed, reset dejam related timers
+            break;
+
+        case GasBurner::State::dejam_post_delay:
+            if (elapsed >= gbc::post_dejam_delay) {
+                // dejam should be completed, the GBC starts over
                 m_dejam_counter += 1;
-                m_dejam_timer = 0;
-                m_next_dejam_attempt_time = 0;
+                m_start_time = Clock::now();
                 m_state = GasBurner::State::starting;
-                GBC_DEBUG(F("|----Dejamming attempt "));
-                GBC_DEBUG(m_dejam_counter);
-                GBC_DEBUGLN(F(" completed"));
+                TRACE(gbc_dejam_done, m_dejam_counter);
             }
-            else {
-                // wait until POST_DEJAM_DELAY has passed
-                GBC_DEBUGLN(F("|----Post dejam wait"));
-            }
-        }
-        else {
-            GBC_DEBUGLN(F("|---Dejam attempt error"));
-            // something went wrong
-            m_state = GasBurner::State::error_other;
-        }
-    }
-    else {
-        // do nothing
-        GBC_DEBUGLN(F("|--Pre dejam waiting"));
+            break;
+
+        default:
+            break;
     }
 }
 
 void GasBurnerControl::start()
 {
-    GBC_DEBUGLN(F(">Start Burner"));
+    TRACE(gbc_start);
     m_ignition_counter = 0;
     m_dejam_counter = 0;
-    m_start_time = millis();
+    m_start_time = Clock::now();
     m_ignition_start_time = 0;
     m_state = GasBurner::State::starting;
     digitalWrite(m_dejam_pin, gbc::low);
@@ -142,7 +110,7 @@ void GasBurnerControl::start()
 
 void GasBurnerControl::stop()
 {
-    GBC_DEBUGLN(F(">Stop Burner"));
+    TRACE(gbc_stop);
     m_ignition_counter = 0;
     m_dejam_counter = 0;
     m_start_time = 0;
@@ -159,81 +127,78 @@ void GasBurnerControl::update()
     m_jammed = digitalRead(m_jammed_pin);
     m_ignition = digitalRead(m_ignition_pin);
 
+    const State previous_state{m_state};
+
     switch (m_state) {
         case GasBurner::State::idle:
             if (digitalRead(m_power_pin) == gbc::low) { // state where Burner is regular off
                 // pass
-                GBC_DEBUGLN(F(">Burner regular off"));
             }
             else if (digitalRead(m_power_pin) == gbc::high) { // state where Burner was powered on outside of class
-                GBC_DEBUGLN(F(">Burner external on"));
+                TRACE(gbc_external_on);
                 start();
             }
             break;
 
         case GasBurner::State::starting: // state startup when Burner was powered on
-            GBC_DEBUGLN(F(">Burner starting"));
             // wait some time after power on before checking the status
-            if (millis() - m_start_time >= gbc::start_delay * 1000) {
-                GBC_DEBUGLN(F("|-Burner start delay passed"));
+            if (Clock::since(m_start_time) >= gbc::start_delay * 1000UL) {
                 if ((m_jammed == gbc::low) & ((m_ignition == gbc::high) | (m_valve == gbc::high))) { // Burner is regular on and attempting ignition
-                    GBC_DEBUGLN(F(">State Change: STARTING -> IGNITION"));
-                    m_ignition_start_time = millis();
+                    m_ignition_start_time = Clock::now();
                     m_ignition_counter += 1;
+                    TRACE(gbc_ignition, m_ignition_counter);
                     m_dejam_counter = 1; // skips immediate dejam attempt
                     m_state = GasBurner::State::ignition;
                 }
                 else if ((m_jammed == gbc::high) & (m_ignition == gbc::low) & (m_valve == gbc::low)) {
-                    GBC_DEBUGLN(F(">State Change: STARTING -> DEJAM"));
                     m_state = GasBurner::State::dejam_start;
                 }
-                else {
-                    GBC_DEBUGLN(F(">State Change: STARTING -> ERROR"));
+                else if ((m_jammed == gbc::high) | (m_ignition == gbc::high) | (m_valve == gbc::high)) {
+                    // jammed while igniting, wiring issue
                     m_state = GasBurner::State::error_other;
                 }
+                else if (Clock::since(m_start_time) >= gbc::start_timeout * 1000UL) {
+                    // GBC never started ignition -> wiring or power supply issue
+                    m_state = GasBurner::State::error_start;
+                }
+                else {
+                    // pass; GBC still waiting before ignition
+                }
             }
             else {
                 // pass; do nothing until start_delay has passed
-                GBC_DEBUGLN(F("|-Burner start waiting"));
             }
             break;
 
         case GasBurner::State::ignition:
-            GBC_DEBUGLN(F(">Burner Ignition"));
             if (m_jammed == gbc::high) { // * at any time if jammed is HIGH, state change to DEJAM
-                GBC_DEBUGLN(F(">State Change: IGNITION -> DEJAM"));
                 m_state = GasBurner::State::dejam_start;
             }
             else if (m_jammed == gbc::low) {
-                if (millis() - m_ignition_start_time >= gbc::ignition_duration * 1000) { // * 20 s ignition valve still on --> state change to RUNNING
+                if (Clock::since(m_ignition_start_time) >= gbc::ignition_duration * 1000UL) { // * 20 s ignition valve still on --> state change to RUNNING
                     if ((m_jammed == gbc::low) & (m_valve == gbc::high)) {
                         m_ignition_counter = 0;
                         m_dejam_counter = 1;
                         m_state = GasBurner::State::running;
                     }
                     else {
-                        GBC_DEBUGLN(F("|-Ignition error A -> ERROR state"));
                         // this can only be reached when hardware is not working properly / wiring issue
                         m_state = GasBurner::State::error_other;
                     }
                 }
                 else {
                     // ignition in progress but not yet completed
-                    GBC_DEBUGLN(F("|-Ignition running but not yet completed"));
                 }
             }
             else {
-                GBC_DEBUGLN(F("|-Ignition error B -> ERROR state"));
                 // TODO: unused option? I should never land here because jammed indicator must be either high or low
                 m_state = GasBurner::State::error_other;
             }
             break;
 
         case GasBurner::State::running:
-            GBC_DEBUGLN(F(">Burner running"));
             // continue checking for error
             if (m_jammed == gbc::high) {
-                GBC_DEBUGLN(F(">State change: RUNNING -> DEJAM"));
                 m_state = GasBurner::State::dejam_start;
             }
             else {
@@ -245,7 +210,6 @@ void GasBurnerControl::update()
         case GasBurner::State::dejam_pre_delay:
         case GasBurner::State::dejam_button_pressed:
         case GasBurner::State::dejam_post_delay:
-            GBC_DEBUGLN(F(">Burner dejam state"));
             // * case ignitionCounter == 0 -> first dejam attempt right away, do not increase dejamCounter
             // * case ignitionCounter > 0 -> wait 60+X s before first dejam attempt
 
@@ -265,19 +229,15 @@ void GasBurnerControl::update()
                 }
             }
             else if ((m_ignition_counter == 0) & (m_dejam_counter == 0)) {
-                GBC_DEBUGLN(F("|-Dejam immediately at first start"));
                 dejam(0);
             }
             else if (m_dejam_counter == 1) {
-                GBC_DEBUGLN(F("|-Dejam after first delay (65ish s?)"));
                 dejam(gbc::dejam_delay_1);
             }
             else if (m_dejam_counter > 1 && m_dejam_counter <= gbc::num_dejam_attempts) {
-                GBC_DEBUGLN(F("|-Dejam secondary attempt 10s delay"));
                 dejam(gbc::dejam_delay_2);
             }
             else {
-                GBC_DEBUGLN(F("|-Unknown Dejam state error: DEJAM -> ERROR"));
                 // should never be reached unless coding with ignition or dejam counter is faulty
                 // can only be reached when dejamCounter == 0 and ignitionCounter > 0
                 m_state = GasBurner::State::error_dejam;
@@ -288,17 +248,24 @@ void GasBurnerControl::update()
         case GasBurner::State::error_ignition:
         case GasBurner::State::error_dejam:
         case GasBurner::State::error_other:
-            GBC_DEBUGLN(F(">Burner error state"));
             // power down but stay in this state
             digitalWrite(m_power_pin, gbc::low);
             digitalWrite(m_dejam_pin, gbc::low);
             break;
 
         default: // any other not defined state is changed to error state, TODO: do i need this with enum class states?
-            GBC_DEBUGLN(F(">Burner unknown state: ? -> ERROR"));
             m_state = GasBurner::State::error_other;
             break;
     } // switch
+
+    // Transitions are all that is needed to reconstruct the flow, at no cost per update.
+    if (m_state != previous_state) {
+        TRACE(gbc_state, static_cast<uint8_t>(previous_state), static_cast<uint8_t>(m_state));
+
+        if (m_state > State::any_error) {
+            TRACE(gbc_error, static_cast<uint8_t>(m_state), m_ignition_counter);
+        }
+    }
 } // GasBurnerControl::update()
 
 GasBurner::State GasBurnerControl::state()
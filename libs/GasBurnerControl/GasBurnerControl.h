@@ -1,10 +1,9 @@
 #pragma once
 
 #include "burner.h"
+#include "clock.h"
 #include <Arduino.h>
 
-//#define GBC_SERIAL_DEBUG            // if uncommented every update will also send a message over serial
-
 class GasBurnerControl : public GasBurner {
 public:
     GasBurnerControl(uint8_t power_pin, uint8_t dejam_pin, uint8_t jammed_pin, uint8_t valve_pin, uint8_t ignition_pin);
@@ -26,10 +25,10 @@ private:
     uint8_t m_ignition_counter{0};
     uint8_t m_dejam_counter{0};
 
-    unsigned long m_start_time{0};
-    unsigned long m_ignition_start_time{0};
-    unsigned long m_next_dejam_attempt_time{0};
-    unsigned long m_dejam_timer{0};
+    Clock::Time m_start_time{0};
+    Clock::Time m_ignition_start_time{0};
+    /// Start of the current dejam phase.
+    Clock::Time m_dejam_timer{0};
 
     State m_state{State::idle};
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Timing of the Satronic 812.2 as GasBurnerControl expects it. Also used by
+ * the box emulator in host/burner-box.h, so that both agree.
+ */
+namespace gbc {
+    /// Initial delay in seconds after powering the GBC.
+    constexpr uint8_t start_delay{2};
+    /// Time in seconds from power on or reset until the GBC must have opened the valve or started the spark.
+    constexpr uint8_t start_timeout{30};
+    /// Time in seconds the GBC ignites without a flame before it locks ("20 s").
+    constexpr uint8_t safety_time{20};
+    /// Wait time in seconds until dejamming is possible ("approx. 60 s").
+    constexpr uint8_t dejam_delay_1{60};
+    /// Wait time in seconds between additional dejam attempts ("approx. 10 s").
+    constexpr uint8_t dejam_delay_2{10};
+    /// Time in seconds after which ignition should be complete.
+    constexpr uint8_t ignition_duration{22};
+    /// Duration of button press in milliseconds during dejamming.
+    constexpr uint16_t dejam_duration{1000};
+    /// Delay after dejam button release in milliseconds.
+    constexpr uint16_t post_dejam_delay{1000};
+}
+
+static_assert(gbc::start_delay < gbc::start_timeout, "start_timeout must allow for the start delay");
+static_assert(gbc::ignition_duration > gbc::safety_time, "ignition must be checked after the GBC would have locked");
@@ -34,14 +34,14 @@ void Ds18b20::begin()
     m_sensors.setResolution(DS18B20_RESOLUTION);
     m_sensors.requestTemperatures();
     set_external_pullup(true);
-    const auto time{millis()};
+    const auto time{Clock::now()};
     m_last_reconnect = time;
     m_last_interaction = time;
 }
 
 unsigned int Ds18b20::last_seen()
 {
-    return millis() - m_last_seen;
+    return Clock::now() - m_last_seen;
 }
 
 bool Ds18b20::is_connected()
@@ -51,7 +51,12 @@ bool Ds18b20::is_connected()
 
 float Ds18b20::temperature()
 {
-    const auto time{millis()};
+    return m_last_temperature;
+}
+
+void Ds18b20::update()
+{
+    const auto time{Clock::now()};
     const auto elapsed_last_seen_ms{time - m_last_seen};
     const auto elapsed_interaction_ms{time - m_last_interaction};
     const auto elapsed_reconnect_ms{time - m_last_reconnect};
@@ -62,7 +67,8 @@ float Ds18b20::temperature()
             begin();
         }
     }
-    if (elapsed_interaction_ms > DS18B20_CONVERSION_DURATION && elapsed_reconnect_ms > DS18B20_CONVERSION_DURATION) {
+    // >= so that a task released exactly every conversion duration reads every time.
+    if (elapsed_interaction_ms >= DS18B20_CONVERSION_DURATION && elapsed_reconnect_ms >= DS18B20_CONVERSION_DURATION) {
         m_last_interaction = time;
         set_external_pullup(false);
         int16_t raw_T = m_sensors.getTemp(m_address);
@@ -74,7 +80,6 @@ float Ds18b20::temperature()
         }
         set_external_pullup(true);
     }
-    return m_last_temperature;
 }
 
 void Ds18b20::set_external_pullup(bool state)
@@ -3,6 +3,7 @@
 /* Deactivate the alarm function of DallasTemperature library */
 #define REQUIRESALARMS false
 
+#include "clock.h"
 #include "sensor.h"
 #include <Arduino.h>
 #include <DallasTemperature.h>
@@ -19,6 +20,7 @@ public:
     Ds18b20(uint8_t pin, uint8_t pin_pullup);
 
     void begin() final;
+    void update() final;
     float temperature() final;
     unsigned int last_seen() final;
     bool is_connected() final;
@@ -29,9 +31,9 @@ private:
     DallasTemperature m_sensors;
     DeviceAddress m_address; // default value required?
     float m_last_temperature{20.0f};
-    unsigned long m_last_seen{0};
-    unsigned long m_last_interaction{0};
-    unsigned long m_last_reconnect{0};
+    Clock::Time m_last_seen{0};
+    Clock::Time m_last_interaction{0};
+    Clock::Time m_last_reconnect{0};
     bool m_disconnected{true};
 
     void reset();
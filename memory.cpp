@@ -0,0 +1,104 @@
+#include "memory.h"
+
+#if defined(__AVR__)
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t __heap_start;
+extern uint8_t __stack;
+extern char* __brkval;
+
+namespace {
+    constexpr uint8_t paint{0xC5};
+
+    uint8_t* heap_end() { return __brkval ? reinterpret_cast<uint8_t*>(__brkval) : &__heap_start; }
+}
+
+/**
+ * Paint from the end of .bss up to the top of the stack. Runs in .init1
+ * before __zero_reg__ and the stack pointer are set up, hence no C code.
+ */
+void paint_stack() __attribute__((naked, used, section(".init1")));
+
+void paint_stack()
+{
+    asm volatile("    ldi r30, lo8(__heap_start)\n"
+                 "    ldi r31, hi8(__heap_start)\n"
+                 "    ldi r24, %[paint]\n"
+                 "    ldi r25, hi8(__stack)\n"
+                 "    rjmp 2f\n"
+                 "1:  st Z+, r24\n"
+                 "2:  cpi r30, lo8(__stack)\n"
+                 "    cpc r31, r25\n"
+                 "    brlo 1b\n"
+                 "    breq 1b\n" ::[paint] "i"(paint)
+                 : "memory");
+}
+
+memory::Usage memory::usage()
+{
+    const uint8_t* const stack_pointer{reinterpret_cast<const uint8_t*>(SP)};
+    const uint8_t* p{heap_end()};
+
+    while (p < stack_pointer && *p == paint) {
+        p++;
+    }
+
+    return Usage{
+        static_cast<uint16_t>(&__data_end - &__data_start),
+        static_cast<uint16_t>(&__bss_end - &__bss_start),
+        static_cast<uint16_t>(heap_end() - &__heap_start),
+        static_cast<uint16_t>(&__stack - p + 1),
+        static_cast<uint16_t>(p - heap_end()),
+        static_cast<uint16_t>(stack_pointer - heap_end()),
+    };
+}
+#else
+memory::Usage memory::usage()
+{
+    return Usage{};
+}
+#endif // __AVR__
+
+namespace {
+    /**
+     * Append @p label and @p value to @p buffer at @p length, keeping room for the terminator.
+     */
+    void append(char* buffer, size_t size, size_t& length, const char* label, uint16_t value)
+    {
+        // vfprintf would cost more flash than the whole feature.
+        char digits[6];
+        uint8_t n{0};
+
+        do {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        } while (value != 0);
+
+        for (; *label != '\0' && length + 1 < size; label++) {
+            buffer[length++] = *label;
+        }
+
+        while (n > 0 && length + 1 < size) {
+            buffer[length++] = digits[--n];
+        }
+
+        buffer[length] = '\0';
+    }
+}
+
+void memory::format(const Usage& usage, char* buffer, size_t size)
+{
+    size_t length{0};
+
+    if (size == 0) {
+        return;
+    }
+
+    append(buffer, size, length, "data ", usage.data);
+    append(buffer, size, length, " bss ", usage.bss);
+    append(buffer, size, length, " heap ", usage.heap);
+    append(buffer, size, length, " stack ", usage.stack);
+    append(buffer, size, length, " unused ", usage.unused);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * SRAM usage of the running firmware.
+ *
+ * Everything between the end of the static data and the initial stack
+ * pointer is painted with a fixed pattern before main(), so the deepest
+ * extent of the stack since boot is where the pattern starts. A local
+ * variable holding the pattern byte at the boundary makes the estimate a few
+ * bytes short.
+ *
+ * Off the AVR all values are 0.
+ */
+namespace memory {
+    struct Usage {
+        /// Initialized globals in bytes.
+        uint16_t data;
+        /// Zero-initialized globals in bytes.
+        uint16_t bss;
+        /// Heap handed out by malloc in bytes.
+        uint16_t heap;
+        /// Deepest stack extent since boot in bytes.
+        uint16_t stack;
+        /// Bytes between heap and stack never touched since boot.
+        uint16_t unused;
+        /// Bytes between heap and the current stack pointer.
+        uint16_t free;
+    };
+
+    /**
+     * Measure usage, scanning the unused area from its bottom.
+     */
+    Usage usage();
+
+    /**
+     * Write @p usage as one line of display text into @p buffer of @p size bytes.
+     */
+    void format(const Usage& usage, char* buffer, size_t size);
+}
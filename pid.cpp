@@ -0,0 +1,67 @@
+#include "pid.h"
+
+Pid::Pid(unsigned long window, unsigned long min_switch_time)
+: m_window{window}
+, m_min_switch_time{min_switch_time}
+{
+}
+
+void Pid::set_gains(const Gains& gains)
+{
+    m_gains = gains;
+    reset();
+}
+
+const Gains& Pid::gains() const
+{
+    return m_gains;
+}
+
+bool Pid::has_gains() const
+{
+    return m_gains.is_set();
+}
+
+void Pid::reset()
+{
+    m_integral = 0.0f;
+    m_started = false;
+}
+
+bool Pid::update(float setpoint, float temperature, unsigned long now)
+{
+    if (!m_started) {
+        m_started = true;
+        m_last_temperature = temperature;
+        m_last_update = now;
+        m_window_start = now - m_window; // start a new window right away
+    }
+
+    // The output is only evaluated once per window, in between we just follow the duty cycle.
+    if (now - m_window_start >= m_window) {
+        const float dt{(now - m_last_update) / 1000.0f};
+        const float error{setpoint - temperature};
+
+        m_integral += m_gains.ki * error * dt;
+        m_integral = constrain(m_integral, 0.0f, 1.0f); // anti-windup
+
+        // Derivative on measurement to avoid kicks on target changes.
+        const float derivative{dt > 0.0f ? (temperature - m_last_temperature) / dt : 0.0f};
+        const float output{constrain(m_gains.kp * error + m_integral - m_gains.kd * derivative, 0.0f, 1.0f)};
+
+        m_on_time = static_cast<unsigned long>(output * m_window);
+
+        if (m_on_time < m_min_switch_time) {
+            m_on_time = 0;
+        }
+        else if (m_window - m_on_time < m_min_switch_time) {
+            m_on_time = m_window;
+        }
+
+        m_last_temperature = temperature;
+        m_last_update = now;
+        m_window_start = now;
+    }
+
+    return now - m_window_start < m_on_time;
+}
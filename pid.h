@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * PID gains for an output normalized to [0, 1].
+ */
+struct Gains {
+    /// Proportional gain in 1 / degree Celsius.
+    float kp{0.0f};
+    /// Integral gain in 1 / (degree Celsius * s).
+    float ki{0.0f};
+    /// Derivative gain in s / degree Celsius.
+    float kd{0.0f};
+
+    /// Return @c true if any gain is set.
+    bool is_set() const { return kp != 0.0f || ki != 0.0f || kd != 0.0f; }
+};
+
+/**
+ * PID controller driving an on/off actuator by time proportioning.
+ *
+ * The continuous controller output is turned into the fraction of a fixed
+ * window during which the actuator is on.
+ */
+class Pid {
+public:
+    /**
+     * @param window Length of the time proportioning window in milliseconds.
+     * @param min_switch_time Shortest on or off time in milliseconds within a window.
+     */
+    Pid(unsigned long window, unsigned long min_switch_time);
+
+    void set_gains(const Gains& gains);
+
+    const Gains& gains() const;
+
+    /**
+     * Return @c true if any gain is set.
+     */
+    bool has_gains() const;
+
+    /**
+     * Forget integral and derivative history, e.g. after a target change.
+     */
+    void reset();
+
+    /**
+     * Compute actuator state.
+     *
+     * @param setpoint Target temperature in degree Celsius.
+     * @param temperature Current temperature in degree Celsius.
+     * @param now Current time in milliseconds.
+     * @return @c true if the actuator should be on.
+     */
+    bool update(float setpoint, float temperature, unsigned long now);
+
+private:
+    const unsigned long m_window;
+    const unsigned long m_min_switch_time;
+    Gains m_gains{};
+    float m_integral{0.0f};
+    float m_last_temperature{0.0f};
+    unsigned long m_last_update{0};
+    unsigned long m_window_start{0};
+    unsigned long m_on_time{0};
+    bool m_started{false};
+};
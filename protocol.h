@@ -0,0 +1,333 @@
+#pragma once
+
+#include "frame.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Command codes, fields and data layouts shared by firmware and host tools.
+ *
+ * Frames are described in frame.h, the commands in README.md. The data part
+ * of every fixed-size message is described once in the schema namespace
+ * below, firmware and host encode and decode through it.
+ */
+namespace protocol {
+    /// Bumped whenever commands or fields change incompatibly.
+    constexpr uint8_t version{2};
+
+    enum class Command : uint8_t {
+        invalid = 0x0,
+        read_state = 0x1,
+        set_brew_temperature = 0x2,
+        set_sparging_temperature = 0x3,
+        read_burner_full_state = 0x4,
+        start_autotune = 0x5,
+        read_autotune = 0x6,
+        upload_schedule = 0x7,
+        control_schedule = 0x8,
+        read_schedule = 0x9,
+        subscribe = 0xA,
+        telemetry = 0xB, // pushed by the device, never received
+        batch_get = 0xC,
+        batch_set = 0xD,
+        read_capabilities = 0xE,
+        set_baud_rate = 0xF,
+        ping = 0x10,
+        subscribe_trace = 0x11,
+        trace = 0x12, // pushed by the device, never received
+        read_timing = 0x13,
+        read_memory = 0x14,
+    };
+
+    /// Bits or'ed into the command code of a reply.
+    enum class Response : uint8_t {
+        ack = 0x80,
+        nack = 0x40,
+    };
+
+    constexpr uint8_t response_mask{static_cast<uint8_t>(Response::ack) | static_cast<uint8_t>(Response::nack)};
+
+    /**
+     * Field IDs used by the batch commands.
+     */
+    enum class Field : uint8_t {
+        brew_temperature = 0x01,     // f32, NaN if disconnected
+        brew_target = 0x02,          // f32, writable
+        sparging_temperature = 0x03, // f32, NaN if disconnected
+        sparging_target = 0x04,      // f32, writable
+        full_burner_state = 0x05,    // u16
+        hotplate_state = 0x06,       // u8
+        dejam_counter = 0x07,        // u8
+        ignition_counter = 0x08,     // u8
+        firmware_version = 0x09,     // string
+        brew_schedule = 0x0A,        // u8 phase, u8 step, u32 remaining seconds
+        sparging_schedule = 0x0B,    // u8 phase, u8 step, u32 remaining seconds
+        uptime = 0x0C,               // u32 milliseconds
+        frames_received = 0x0D,      // u16
+        frames_rejected = 0x0E,      // u16
+        unused_memory = 0x0F,        // u16 bytes, never touched by the stack
+    };
+
+    /// Longest firmware version string sent, in bytes.
+    constexpr uint8_t max_version_size{8};
+
+    /// Centi-degree value of a disconnected sensor.
+    constexpr int16_t disconnected{-32767 - 1};
+
+    /**
+     * Telemetry values, temperatures in centi-degrees.
+     */
+    struct Telemetry {
+        int16_t brew;
+        int16_t brew_target;
+        int16_t sparging;
+        int16_t sparging_target;
+        uint16_t full_burner_state;
+        uint8_t flags;
+    };
+
+    /**
+     * Compile-time description of message data layouts.
+     *
+     * A message lists its fields with their offsets, the offsets are checked
+     * to be contiguous and the total size to fit into a frame. Accessors copy
+     * from and to fixed offsets of the frame buffer without any branching, so
+     * they compile to plain loads and stores.
+     */
+    namespace schema {
+        /**
+         * Little-endian value of type @p T at byte @p Offset.
+         */
+        template <typename T, uint8_t Offset>
+        struct Field {
+            using type = T;
+            static constexpr uint8_t offset{Offset};
+            static constexpr uint8_t end{Offset + sizeof(T)};
+
+            static void store(uint8_t* data, const T& value) { memcpy(data + Offset, &value, sizeof(T)); }
+
+            static T load(const uint8_t* data)
+            {
+                T value;
+                memcpy(&value, data + Offset, sizeof(T));
+                return value;
+            }
+        };
+
+        /**
+         * Temperature as f32, NaN if the sensor is disconnected.
+         */
+        template <uint8_t Offset>
+        struct Temperature : Field<float, Offset> {
+            static void store(uint8_t* data, float value, bool is_connected)
+            {
+                // 0x7fffffff corresponds to IEEE 754 NaN
+                const uint32_t nan{0x7fffffff};
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                bits = is_connected ? bits : nan;
+                memcpy(data + Offset, &bits, sizeof(bits));
+            }
+
+            static bool is_connected(const uint8_t* data)
+            {
+                const float value{Field<float, Offset>::load(data)};
+                return value == value;
+            }
+        };
+
+        template <uint8_t Offset, typename... Fields>
+        struct Layout {
+            static constexpr uint8_t size{Offset};
+        };
+
+        template <uint8_t Offset, typename First, typename... Rest>
+        struct Layout<Offset, First, Rest...> {
+            static_assert(First::offset == Offset, "fields must be listed in order without gaps");
+            static constexpr uint8_t size{Layout<First::end, Rest...>::size};
+        };
+
+        /**
+         * Fixed-size message made of @p Fields, which must be listed in order.
+         */
+        template <typename... Fields>
+        struct Message {
+            static constexpr uint8_t size{Layout<0, Fields...>::size};
+            static_assert(size <= frame::max_data_size, "message does not fit into a frame");
+        };
+
+        struct ReadStateReply {
+            using brew = Temperature<0>;
+            using brew_target = Field<float, 4>;
+            using sparging = Temperature<8>;
+            using sparging_target = Field<float, 12>;
+            /// Burner state in bits 0-5, hotplate on in bit 7.
+            using state = Field<uint8_t, 16>;
+
+            static constexpr uint8_t size{Message<brew, brew_target, sparging, sparging_target, state>::size};
+        };
+
+        struct SetTemperatureRequest {
+            using temperature = Field<float, 0>;
+
+            static constexpr uint8_t size{Message<temperature>::size};
+        };
+
+        struct ReadBurnerFullStateReply {
+            using state = Field<uint16_t, 0>;
+
+            static constexpr uint8_t size{Message<state>::size};
+        };
+
+        struct ChannelRequest {
+            using channel = Field<uint8_t, 0>;
+
+            static constexpr uint8_t size{Message<channel>::size};
+        };
+
+        struct StartAutotuneRequest {
+            using channel = Field<uint8_t, 0>;
+            using setpoint = Field<float, 1>;
+
+            static constexpr uint8_t size{Message<channel, setpoint>::size};
+        };
+
+        struct ReadAutotuneReply {
+            using state = Field<uint8_t, 0>;
+            using kp = Field<float, 1>;
+            using ki = Field<float, 5>;
+            using kd = Field<float, 9>;
+
+            static constexpr uint8_t size{Message<state, kp, ki, kd>::size};
+        };
+
+        struct ControlScheduleRequest {
+            using channel = Field<uint8_t, 0>;
+            using start = Field<uint8_t, 1>;
+
+            static constexpr uint8_t size{Message<channel, start>::size};
+        };
+
+        struct ReadScheduleReply {
+            using phase = Field<uint8_t, 0>;
+            using step = Field<uint8_t, 1>;
+            /// Remaining seconds.
+            using remaining = Field<uint32_t, 2>;
+
+            static constexpr uint8_t size{Message<phase, step, remaining>::size};
+        };
+
+        struct SubscribeRequest {
+            /// Period in milliseconds, 0 unsubscribes.
+            using period = Field<uint16_t, 0>;
+            /// Deadband in centi-degrees, 0 disables.
+            using deadband = Field<uint16_t, 2>;
+
+            static constexpr uint8_t size{Message<period, deadband>::size};
+        };
+
+        struct TelemetryPush {
+            using brew = Field<int16_t, 0>;
+            using brew_target = Field<int16_t, 2>;
+            using sparging = Field<int16_t, 4>;
+            using sparging_target = Field<int16_t, 6>;
+            using full_burner_state = Field<uint16_t, 8>;
+            /// Hotplate on in bit 0.
+            using flags = Field<uint8_t, 10>;
+
+            static constexpr uint8_t size{Message<brew, brew_target, sparging, sparging_target, full_burner_state, flags>::size};
+
+            static void store(uint8_t* data, const Telemetry& telemetry)
+            {
+                brew::store(data, telemetry.brew);
+                brew_target::store(data, telemetry.brew_target);
+                sparging::store(data, telemetry.sparging);
+                sparging_target::store(data, telemetry.sparging_target);
+                full_burner_state::store(data, telemetry.full_burner_state);
+                flags::store(data, telemetry.flags);
+            }
+
+            static Telemetry load(const uint8_t* data) { return Telemetry{brew::load(data), brew_target::load(data), sparging::load(data), sparging_target::load(data), full_burner_state::load(data), flags::load(data)}; }
+        };
+
+        /// Followed by the firmware version string, cut to max_version_size.
+        struct ReadCapabilitiesReply {
+            using version = Field<uint8_t, 0>;
+            /// Bit n set if batch field n is supported.
+            using fields = Field<uint32_t, 1>;
+            using features = Field<uint16_t, 5>;
+
+            static constexpr uint8_t size{Message<version, fields, features>::size};
+        };
+
+        struct SubscribeTraceRequest {
+            /// 1 to push trace records, 0 to stop.
+            using enable = Field<uint8_t, 0>;
+
+            static constexpr uint8_t size{Message<enable>::size};
+        };
+
+        /// A trace push carries as many records as fit into the frame.
+        struct TraceRecord {
+            /// Index into TRACE_EVENTS.
+            using event = Field<uint8_t, 0>;
+            /// Milliseconds since boot.
+            using time = Field<uint32_t, 1>;
+            using a = Field<uint16_t, 5>;
+            using b = Field<uint16_t, 7>;
+
+            static constexpr uint8_t size{Message<event, time, a, b>::size};
+        };
+
+        struct ReadTimingRequest {
+            /// Index into TIMING_PHASES.
+            using phase = Field<uint8_t, 0>;
+            /// 1 to clear the phase's statistics after reading them.
+            using reset = Field<uint8_t, 1>;
+
+            static constexpr uint8_t size{Message<phase, reset>::size};
+        };
+
+        /// Runtimes in microseconds, followed by 16 u16 histogram buckets.
+        struct ReadTimingReply {
+            using count = Field<uint32_t, 0>;
+            using min = Field<uint32_t, 4>;
+            using max = Field<uint32_t, 8>;
+            /// Exponentially weighted mean.
+            using mean = Field<uint32_t, 12>;
+
+            static constexpr uint8_t size{Message<count, min, max, mean>::size};
+            static constexpr uint8_t buckets{16};
+        };
+
+        struct ReadMemoryRequest {
+            /// 1 to also show the usage on the display.
+            using show = Field<uint8_t, 0>;
+
+            static constexpr uint8_t size{Message<show>::size};
+        };
+
+        /// Sizes in bytes, see memory.h.
+        struct ReadMemoryReply {
+            using data = Field<uint16_t, 0>;
+            using bss = Field<uint16_t, 2>;
+            using heap = Field<uint16_t, 4>;
+            using stack = Field<uint16_t, 6>;
+            using unused = Field<uint16_t, 8>;
+            using free = Field<uint16_t, 10>;
+
+            static constexpr uint8_t size{Message<data, bss, heap, stack, unused, free>::size};
+        };
+
+        struct SetBaudRateRequest {
+            using baud_rate = Field<uint32_t, 0>;
+
+            static constexpr uint8_t size{Message<baud_rate>::size};
+        };
+
+        static_assert(ReadStateReply::size == 17, "read_state reply changed");
+        static_assert(TelemetryPush::size == 11, "telemetry changed");
+        static_assert(ReadCapabilitiesReply::size + max_version_size <= frame::max_data_size, "no room for the version string");
+        static_assert(ReadTimingReply::size + ReadTimingReply::buckets * 2 <= frame::max_data_size, "no room for the histogram");
+    }
+}
@@ -0,0 +1,166 @@
+#include "schedule.h"
+#include "settings.h"
+
+namespace {
+    /// Distance to the target in degree Celsius at which the rest begins.
+    constexpr float tolerance{0.5f};
+}
+
+Schedule::Schedule(Controller& controller, Controller::Channel channel)
+: m_controller{controller}
+, m_channel{channel}
+{
+}
+
+bool Schedule::set_steps(const ScheduleStep* steps, uint8_t count)
+{
+    if (count > max_steps) {
+        return false;
+    }
+
+    stop();
+    settings::store_schedule(static_cast<uint8_t>(m_channel), steps, count);
+    return true;
+}
+
+bool Schedule::start()
+{
+    m_count = settings::load_schedule_count(static_cast<uint8_t>(m_channel));
+
+    if (m_count == 0) {
+        return false;
+    }
+
+    begin_step(0);
+    return true;
+}
+
+void Schedule::stop()
+{
+    m_phase = Phase::idle;
+}
+
+void Schedule::update(unsigned long elapsed)
+{
+    if (m_phase == Phase::idle || m_phase == Phase::done) {
+        return;
+    }
+
+    // Someone else took over.
+    if (target_temperature() != m_setpoint) {
+        stop();
+        return;
+    }
+
+    const float target{m_step.target / 100.0f};
+
+    switch (m_phase) {
+        case Phase::ramp: {
+            const float delta{m_step.ramp_rate / 100.0f * elapsed / 60000.0f};
+
+            if (m_rising) {
+                m_setpoint = min(m_setpoint + delta, target);
+            }
+            else {
+                m_setpoint = max(m_setpoint - delta, target);
+            }
+
+            if (m_setpoint == target) {
+                m_phase = Phase::wait;
+            }
+
+            set_target_temperature(m_setpoint);
+        } break;
+
+        case Phase::wait: {
+            const float current{temperature()};
+
+            if ((m_rising && current >= target - tolerance) || (!m_rising && current <= target + tolerance)) {
+                m_phase = Phase::hold;
+            }
+        } break;
+
+        case Phase::hold:
+            if (elapsed < m_remaining) {
+                m_remaining -= elapsed;
+            }
+            else if (m_index + 1 < m_count) {
+                begin_step(m_index + 1);
+            }
+            else {
+                m_remaining = 0;
+                m_phase = Phase::done;
+            }
+            break;
+
+        case Phase::idle:
+        case Phase::done:
+            break;
+    }
+}
+
+Schedule::Phase Schedule::phase() const
+{
+    return m_phase;
+}
+
+uint8_t Schedule::current_step() const
+{
+    return m_index;
+}
+
+uint32_t Schedule::remaining() const
+{
+    return m_remaining / 1000;
+}
+
+void Schedule::begin_step(uint8_t index)
+{
+    if (!settings::load_schedule_step(static_cast<uint8_t>(m_channel), index, m_step)) {
+        stop();
+        return;
+    }
+
+    const float target{m_step.target / 100.0f};
+
+    // Ramp from the active target or, if the channel is off, from the current temperature.
+    m_setpoint = target_temperature();
+
+    if (m_setpoint == 0.0f) {
+        m_setpoint = temperature();
+    }
+
+    m_index = index;
+    m_rising = target >= m_setpoint;
+    m_remaining = m_step.hold * 60000UL;
+
+    if (m_step.ramp_rate == 0) {
+        m_setpoint = target;
+        m_phase = Phase::wait;
+    }
+    else {
+        m_phase = Phase::ramp;
+    }
+
+    set_target_temperature(m_setpoint);
+}
+
+float Schedule::target_temperature()
+{
+    return m_channel == Controller::Channel::brew ? m_controller.brew_target_temperature() : m_controller.sparging_target_temperature();
+}
+
+float Schedule::temperature()
+{
+    return m_channel == Controller::Channel::brew ? m_controller.brew_temperature() : m_controller.sparging_temperature();
+}
+
+void Schedule::set_target_temperature(float temperature)
+{
+    if (m_channel == Controller::Channel::brew) {
+        m_controller.set_brew_temperature(temperature);
+    }
+    else {
+        m_controller.set_sparging_temperature(temperature);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "controller.h"
+#include <Arduino.h>
+
+/**
+ * A single step of a mash schedule.
+ */
+struct ScheduleStep {
+    /// Target temperature in centi-degree Celsius.
+    int16_t target;
+    /// Ramp rate in centi-degree Celsius per minute, 0 sets the target right away.
+    uint16_t ramp_rate;
+    /// Rest duration in minutes once the target is reached.
+    uint16_t hold;
+} __attribute__((packed));
+
+/**
+ * Autonomous executor of a multi-step ramp/rest schedule for one channel.
+ *
+ * Steps are kept in EEPROM and only the current one is loaded into RAM. The
+ * schedule ends with the last target kept set. Setting a different target
+ * from the outside while running stops the schedule.
+ */
+class Schedule {
+public:
+    static constexpr uint8_t max_steps{8};
+
+    enum class Phase : uint8_t {
+        idle = 0,
+        /// Setpoint moves towards the step target at the ramp rate.
+        ramp = 1,
+        /// Setpoint reached, waiting for the temperature to follow.
+        wait = 2,
+        /// Resting at the step target.
+        hold = 3,
+        /// All steps completed.
+        done = 4,
+    };
+
+    Schedule(Controller& controller, Controller::Channel channel);
+
+    /**
+     * Replace and persist the schedule. Stops a running schedule.
+     *
+     * @return @c false if @p count exceeds max_steps.
+     */
+    bool set_steps(const ScheduleStep* steps, uint8_t count);
+
+    /**
+     * Run stored schedule from the first step.
+     *
+     * @return @c false if no schedule is stored.
+     */
+    bool start();
+
+    /**
+     * Stop schedule and leave the current target set.
+     */
+    void stop();
+
+    /**
+     * Advance the schedule, call right after Controller::update().
+     *
+     * @param elapsed Number of milliseconds elapsed since last call.
+     */
+    void update(unsigned long elapsed);
+
+    Phase phase() const;
+
+    /**
+     * Index of the current step.
+     */
+    uint8_t current_step() const;
+
+    /**
+     * Remaining rest time of the current step in seconds.
+     */
+    uint32_t remaining() const;
+
+private:
+    void begin_step(uint8_t index);
+
+    float target_temperature();
+
+    float temperature();
+
+    void set_target_temperature(float temperature);
+
+    Controller& m_controller;
+    const Controller::Channel m_channel;
+    Phase m_phase{Phase::idle};
+    uint8_t m_count{0};
+    uint8_t m_index{0};
+    ScheduleStep m_step{};
+    float m_setpoint{0.0f};
+    bool m_rising{true};
+    unsigned long m_remaining{0};
+};
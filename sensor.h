@@ -1,6 +1,9 @@
 #pragma once
 
+#if defined(HAVE_CONFIG_H)
 #include "config.h"
+#endif
+#include "clock.h"
 
 /**
  * Temperature sensor interface.
@@ -10,7 +13,13 @@ public:
     virtual void begin();
 
     /**
-     * Read the current temperature.
+     * Poll the sensor and start the next conversion if due. Must be called
+     * repeatedly, at least as often as the conversion time.
+     */
+    virtual void update() = 0;
+
+    /**
+     * Read the last converted temperature.
      */
     virtual float temperature() = 0;
 
@@ -31,9 +40,29 @@ class MockTemperatureSensor : public TemperatureSensor {
 public:
     void begin() final {}
 
-    float temperature() final { return 20.0f; }
+    void update() final {}
+
+    /**
+     * Report @p temperature from now on, read successfully if @p connected.
+     */
+    void set(float temperature, bool connected)
+    {
+        if (m_connected && !connected) {
+            m_lost = Clock::now();
+        }
+
+        m_temperature = temperature;
+        m_connected = connected;
+    }
+
+    float temperature() final { return m_temperature; }
+
+    unsigned int last_seen() final { return m_connected ? 0 : Clock::since(m_lost); }
 
-    unsigned int last_seen() final { return 0; }
+    bool is_connected() final { return m_connected; }
 
-    bool is_connected() final { return true; }
+private:
+    float m_temperature{20.0f};
+    bool m_connected{true};
+    Clock::Time m_lost{0};
 };
@@ -0,0 +1,134 @@
+#include "settings.h"
+#include "schedule.h"
+#include <EEPROM.h>
+
+namespace {
+    /// Marks an initialized record, bump when changing the layout.
+    constexpr uint8_t magic{0xB1};
+
+    struct GainsRecord {
+        uint8_t magic;
+        Gains gains;
+        uint8_t checksum;
+    };
+
+    struct ScheduleHeader {
+        uint8_t magic;
+        uint8_t count;
+        uint8_t checksum;
+    };
+
+    /// EEPROM layout.
+    constexpr int gains_address{0};
+    constexpr int schedule_address{64};
+    constexpr int schedule_stride{64};
+    constexpr uint8_t num_channels{2};
+
+    static_assert(num_channels * sizeof(GainsRecord) <= schedule_address, "Gains overlap schedules");
+    static_assert(sizeof(ScheduleHeader) + Schedule::max_steps * sizeof(ScheduleStep) <= schedule_stride, "Schedule exceeds its slot");
+
+    uint8_t checksum(uint8_t sum, const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++) {
+            sum = (sum << 1 | sum >> 7) ^ data[i];
+        }
+
+        return sum;
+    }
+
+    uint8_t checksum(const GainsRecord& record)
+    {
+        return checksum(magic, reinterpret_cast<const uint8_t*>(&record.gains), sizeof(Gains));
+    }
+
+    int schedule_step_address(uint8_t channel, uint8_t index)
+    {
+        return schedule_address + channel * schedule_stride + sizeof(ScheduleHeader) + index * sizeof(ScheduleStep);
+    }
+
+    uint8_t schedule_checksum(uint8_t channel, uint8_t count)
+    {
+        uint8_t sum{checksum(magic, &count, 1)};
+
+        for (uint8_t i = 0; i < count; i++) {
+            ScheduleStep step;
+            EEPROM.get(schedule_step_address(channel, i), step);
+            sum = checksum(sum, reinterpret_cast<const uint8_t*>(&step), sizeof(ScheduleStep));
+        }
+
+        return sum;
+    }
+}
+
+bool settings::load_gains(uint8_t channel, Gains& gains)
+{
+    if (channel >= num_channels) {
+        return false;
+    }
+
+    GainsRecord record;
+    EEPROM.get(gains_address + channel * sizeof(GainsRecord), record);
+
+    if (record.magic != magic || record.checksum != checksum(record)) {
+        return false;
+    }
+
+    gains = record.gains;
+    return true;
+}
+
+void settings::store_gains(uint8_t channel, const Gains& gains)
+{
+    if (channel >= num_channels) {
+        return;
+    }
+
+    GainsRecord record;
+    record.magic = magic;
+    record.gains = gains;
+    record.checksum = checksum(record);
+    EEPROM.put(gains_address + channel * sizeof(GainsRecord), record);
+}
+
+uint8_t settings::load_schedule_count(uint8_t channel)
+{
+    if (channel >= num_channels) {
+        return 0;
+    }
+
+    ScheduleHeader header;
+    EEPROM.get(schedule_address + channel * schedule_stride, header);
+
+    if (header.magic != magic || header.count > Schedule::max_steps || header.checksum != schedule_checksum(channel, header.count)) {
+        return 0;
+    }
+
+    return header.count;
+}
+
+bool settings::load_schedule_step(uint8_t channel, uint8_t index, ScheduleStep& step)
+{
+    if (channel >= num_channels || index >= Schedule::max_steps) {
+        return false;
+    }
+
+    EEPROM.get(schedule_step_address(channel, index), step);
+    return true;
+}
+
+void settings::store_schedule(uint8_t channel, const ScheduleStep* steps, uint8_t count)
+{
+    if (channel >= num_channels || count > Schedule::max_steps) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        EEPROM.put(schedule_step_address(channel, i), steps[i]);
+    }
+
+    ScheduleHeader header;
+    header.magic = magic;
+    header.count = count;
+    header.checksum = schedule_checksum(channel, count);
+    EEPROM.put(schedule_address + channel * schedule_stride, header);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pid.h"
+#include <Arduino.h>
+
+struct ScheduleStep;
+
+/**
+ * Persistent settings stored in EEPROM.
+ */
+namespace settings {
+    /**
+     * Load PID gains of @p channel.
+     *
+     * @return @c false if nothing valid has been stored yet.
+     */
+    bool load_gains(uint8_t channel, Gains& gains);
+
+    /**
+     * Store PID gains of @p channel.
+     */
+    void store_gains(uint8_t channel, const Gains& gains);
+
+    /**
+     * Get number of stored schedule steps of @p channel.
+     *
+     * @return 0 if nothing valid has been stored yet.
+     */
+    uint8_t load_schedule_count(uint8_t channel);
+
+    /**
+     * Load schedule step @p index of @p channel.
+     */
+    bool load_schedule_step(uint8_t channel, uint8_t index, ScheduleStep& step);
+
+    /**
+     * Store @p count schedule steps of @p channel.
+     */
+    void store_schedule(uint8_t channel, const ScheduleStep* steps, uint8_t count);
+}
@@ -0,0 +1,76 @@
+#include "tasks.h"
+
+TaskScheduler::TaskScheduler(Task* tasks, uint8_t count)
+: m_tasks{tasks}
+, m_count{count}
+{
+}
+
+void TaskScheduler::begin()
+{
+    const auto now{Clock::now()};
+
+    for (uint8_t i = 0; i < m_count; i++) {
+        m_tasks[i].next = now;
+    }
+}
+
+void TaskScheduler::run()
+{
+    const auto now{Clock::now()};
+
+    for (uint8_t i = 0; i < m_count; i++) {
+        Task& task{m_tasks[i]};
+
+        // Tasks without period run on every pass and never advance their
+        // release time, so only periodic ones have a lateness.
+        if (task.period != 0) {
+            const int32_t lateness{static_cast<int32_t>(now - task.next)};
+
+            if (lateness < 0) {
+                continue;
+            }
+
+            task.worst_jitter = max(task.worst_jitter, static_cast<uint16_t>(min(lateness, static_cast<int32_t>(0xFFFF))));
+
+            if (lateness > task.deadline) {
+                task.missed++;
+            }
+
+            // Keep the phase unless we fell behind by more than a period.
+            task.next += task.period;
+
+            if (static_cast<int32_t>(now - task.next) >= 0) {
+                task.next = now + task.period;
+            }
+        }
+
+        const auto start{micros()};
+        task.run(now);
+        task.worst_runtime = max(task.worst_runtime, micros() - start);
+
+        // Event-driven tasks only poll, so give periodic ones a chance.
+        if (task.period != 0) {
+            return;
+        }
+    }
+}
+
+void TaskScheduler::reset_statistics()
+{
+    for (uint8_t i = 0; i < m_count; i++) {
+        m_tasks[i].worst_runtime = 0;
+        m_tasks[i].worst_jitter = 0;
+        m_tasks[i].missed = 0;
+    }
+}
+
+uint8_t TaskScheduler::count() const
+{
+    return m_count;
+}
+
+const Task& TaskScheduler::task(uint8_t index) const
+{
+    return m_tasks[index];
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "clock.h"
+#include <Arduino.h>
+
+/**
+ * Entry of a static cooperative task table.
+ */
+struct Task {
+    Task(void (*run)(Clock::Time), uint16_t period, uint16_t deadline)
+    : run{run}
+    , period{period}
+    , deadline{deadline}
+    {
+    }
+
+    /// Function to run, receives the current time in milliseconds.
+    void (*run)(Clock::Time now);
+    /// Release period in milliseconds, 0 releases the task on every pass.
+    uint16_t period;
+    /// Allowed lateness in milliseconds before a release counts as missed.
+    uint16_t deadline;
+    /// Next release time in milliseconds.
+    Clock::Time next{0};
+    /// Worst-case runtime in microseconds.
+    unsigned long worst_runtime{0};
+    /// Worst-case release lateness (jitter) in milliseconds.
+    uint16_t worst_jitter{0};
+    /// Number of releases later than the deadline.
+    uint16_t missed{0};
+};
+
+/**
+ * Non-preemptive fixed-period scheduler.
+ *
+ * Tasks are prioritized by their position in the table. Each call to run()
+ * executes at most one task, the first one that is due, so a long task delays
+ * a higher priority one by at most its own runtime.
+ */
+class TaskScheduler {
+public:
+    TaskScheduler(Task* tasks, uint8_t count);
+
+    /**
+     * Release all tasks now, call at the end of setup().
+     */
+    void begin();
+
+    /**
+     * Execute the highest priority due task, call from loop().
+     */
+    void run();
+
+    /**
+     * Reset runtime and jitter statistics.
+     */
+    void reset_statistics();
+
+    uint8_t count() const;
+
+    const Task& task(uint8_t index) const;
+
+private:
+    Task* m_tasks;
+    const uint8_t m_count;
+};
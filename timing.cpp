@@ -0,0 +1,51 @@
+#include "timing.h"
+
+#if defined(WITH_TIMING)
+namespace {
+    timing::Statistics phases[static_cast<uint8_t>(timing::Phase::count)];
+
+    uint8_t bucket(uint32_t microseconds)
+    {
+        uint8_t n{0};
+
+        for (microseconds >>= 4; microseconds != 0 && n < timing::buckets - 1; microseconds >>= 1) {
+            n++;
+        }
+
+        return n;
+    }
+}
+
+void timing::record(Phase phase, uint32_t microseconds)
+{
+    Statistics& statistics{phases[static_cast<uint8_t>(phase)]};
+
+    if (statistics.count == 0) {
+        statistics.min = microseconds;
+        statistics.mean = microseconds << 4;
+    }
+
+    statistics.count++;
+    statistics.min = min(statistics.min, microseconds);
+    statistics.max = max(statistics.max, microseconds);
+    // mean += (sample - mean) / 16 in 1/16 us, without going negative.
+    statistics.mean = statistics.mean - (statistics.mean >> 4) + microseconds;
+
+    uint16_t& count{statistics.histogram[bucket(microseconds)]};
+
+    if (count < 0xFFFF) {
+        count++;
+    }
+}
+
+const timing::Statistics& timing::statistics(Phase phase)
+{
+    return phases[static_cast<uint8_t>(phase)];
+}
+
+void timing::reset(Phase phase)
+{
+    phases[static_cast<uint8_t>(phase)] = Statistics{};
+}
+
+#endif // WITH_TIMING
@@ -0,0 +1,72 @@
+#pragma once
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+#include "timing_phases.h"
+#include <Arduino.h>
+
+/**
+ * Runtime statistics of the main loop and its phases.
+ *
+ * Each phase keeps the number of samples, minimum, maximum, an exponentially
+ * weighted mean and a histogram with logarithmic buckets of its runtime in
+ * microseconds, read and reset through the read_timing command.
+ *
+ * Without WITH_TIMING the TIMING() macro compiles to nothing.
+ */
+namespace timing {
+    enum class Phase : uint8_t {
+#define TIMING_ENUM(name, description) name,
+        TIMING_PHASES(TIMING_ENUM)
+#undef TIMING_ENUM
+        count,
+    };
+
+    /// Bucket 0 counts runtimes below 16 us, bucket n those of 2^(n+3) to
+    /// 2^(n+4) - 1 us and the last one everything from 262144 us on.
+    constexpr uint8_t buckets{16};
+
+    struct Statistics {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        /// Mean in 1/16 us, each sample weighs 1/16.
+        uint32_t mean;
+        /// Saturating sample counts.
+        uint16_t histogram[buckets];
+    };
+
+    /**
+     * Account a runtime of @p microseconds to @p phase.
+     */
+    void record(Phase phase, uint32_t microseconds);
+
+    const Statistics& statistics(Phase phase);
+
+    void reset(Phase phase);
+
+    /**
+     * Records the lifetime of the object.
+     */
+    class Scope {
+    public:
+        explicit Scope(Phase phase)
+        : m_phase{phase}
+        , m_start{micros()}
+        {
+        }
+
+        ~Scope() { record(m_phase, micros() - m_start); }
+
+    private:
+        const Phase m_phase;
+        const uint32_t m_start;
+    };
+}
+
+#if defined(WITH_TIMING)
+#define TIMING(phase) const timing::Scope timing_scope_##phase{timing::Phase::phase}
+#else
+#define TIMING(phase)
+#endif
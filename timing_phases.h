@@ -0,0 +1,16 @@
+#pragma once
+
+/**
+ * Timing phase table shared by firmware and host tools.
+ *
+ * X(name, description). IDs are assigned in order and used by read_timing,
+ * so only ever append.
+ */
+#define TIMING_PHASES(X)                                    \
+    X(loop, "loop() pass")                                  \
+    X(comm, "serial frame handling")                        \
+    X(gbc, "gas burner control")                            \
+    X(sensor, "temperature sensor I/O")                     \
+    X(control, "controller and schedules")                  \
+    X(ui, "input handling and rendering")                   \
+    X(flush, "display transfer")
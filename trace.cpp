@@ -0,0 +1,53 @@
+#include "trace.h"
+
+#if defined(WITH_TRACE)
+namespace {
+    trace::Record buffer[trace::capacity];
+    volatile uint8_t head{0};
+    volatile uint8_t count{0};
+    volatile uint16_t dropped{0};
+}
+
+void trace::record(Event event, uint16_t a, uint16_t b)
+{
+    const uint8_t sreg{SREG};
+    noInterrupts();
+
+    if (count == capacity) {
+        if (dropped < 0xFFFF) {
+            dropped++;
+        }
+    }
+    else {
+        buffer[(head + count) % capacity] = Record{event, Clock::now(), a, b};
+        count++;
+    }
+
+    SREG = sreg;
+}
+
+bool trace::pop(Record& record)
+{
+    const uint8_t sreg{SREG};
+    noInterrupts();
+    bool available{true};
+
+    if (count > 0) {
+        record = buffer[head];
+        head = (head + 1) % capacity;
+        count--;
+    }
+    else if (dropped > 0) {
+        // Drops happened after everything kept, so report them last.
+        record = Record{Event::overflow, Clock::now(), dropped, 0};
+        dropped = 0;
+    }
+    else {
+        available = false;
+    }
+
+    SREG = sreg;
+    return available;
+}
+
+#endif // WITH_TRACE
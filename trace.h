@@ -0,0 +1,55 @@
+#pragma once
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+#include "clock.h"
+#include "trace_events.h"
+#include <Arduino.h>
+
+/**
+ * Binary trace channel.
+ *
+ * Trace points store a 1-byte event ID, a millisecond timestamp and two u16
+ * arguments in a RAM ring buffer. Formatting happens on the host (see
+ * trace_events.h), the records are drained by Comm as protocol frames when
+ * the link is idle. If the buffer is full new records are dropped and an
+ * overflow record with the number of drops is emitted once it drained.
+ *
+ * Without WITH_TRACE the TRACE() macro compiles to nothing.
+ */
+namespace trace {
+    enum class Event : uint8_t {
+#define TRACE_ENUM(name, format) name,
+        TRACE_EVENTS(TRACE_ENUM)
+#undef TRACE_ENUM
+    };
+
+    struct Record {
+        Event event;
+        Clock::Time time;
+        uint16_t a;
+        uint16_t b;
+    };
+
+    /// Number of records kept until drained.
+    constexpr uint8_t capacity{16};
+
+    /**
+     * Store a record, safe to call from interrupts.
+     */
+    void record(Event event, uint16_t a = 0, uint16_t b = 0);
+
+    /**
+     * Remove the oldest record.
+     *
+     * @return @c false if there is none.
+     */
+    bool pop(Record& record);
+}
+
+#if defined(WITH_TRACE)
+#define TRACE(event, ...) trace::record(trace::Event::event, ##__VA_ARGS__)
+#else
+#define TRACE(event, ...)
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * Trace event table shared by firmware and host tools.
+ *
+ * X(name, format) with a printf format for the two u16 arguments. IDs are
+ * assigned in order, so only ever append to keep recorded traces readable.
+ */
+#define TRACE_EVENTS(X)                                                     \
+    X(overflow, "%u records dropped")                                       \
+    X(gbc_start, "burner start")                                            \
+    X(gbc_stop, "burner stop")                                              \
+    X(gbc_external_on, "burner powered on externally")                      \
+    X(gbc_state, "burner state %u -> %u")                                   \
+    X(gbc_ignition, "ignition attempt %u")                                  \
+    X(gbc_dejam_scheduled, "dejam in %u s, attempt %u")                     \
+    X(gbc_dejam_press, "dejam button pressed, attempt %u")                  \
+    X(gbc_dejam_release, "dejam button released, attempt %u")               \
+    X(gbc_dejam_done, "dejam attempt %u completed")                         \
+    X(gbc_dejam_error, "dejam button in unexpected state %u")               \
+    X(gbc_error, "burner error in state %u, ignitions %u")                  \
+    X(input_pins, "inputs %04x, changed %04x")                              \
+    X(input_brew_sensor, "brew sensor %u/16 degrees, connected %u")         \
+    X(input_sparging_sensor, "sparging sensor %u/16 degrees, connected %u") \
+    X(input_event, "input source %u, %hd steps")
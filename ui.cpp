@@ -1,5 +1,6 @@
 #include "ui.h"
 #include "fonts.h"
+#include "timing.h"
 
 Ui::Ui(Display& display, const char* welcome)
 : m_display{display}
@@ -20,7 +21,7 @@ Ui::Layout Ui::freeze_layout(bool freeze)
 {
     m_freeze_layout = freeze;
     if (!m_freeze_layout) {
-        m_last_layout_switch = millis();
+        m_last_layout_switch = Clock::now();
     }
     return m_current_layout;
 }
@@ -75,9 +76,16 @@ void Ui::set_full_burner_state(uint16_t state)
     m_full_burner_state = state;
 }
 
+void Ui::show_message(const char* message)
+{
+    m_welcome_last = message;
+    m_current_scroll_start = 127;
+    m_refresh = true;
+}
+
 void Ui::update()
 {
-    const auto now{millis()};
+    const auto now{Clock::now()};
 
     // Bail out early if there is nothing to redraw.
     if ((now - m_last_update) < 15 || (!m_refresh && (m_welcome == nullptr))) {
@@ -90,13 +98,13 @@ void Ui::update()
     if (m_layout_switching && !m_freeze_layout) {
         switch (m_current_layout) {
             case LayoutA:
-                if (m_last_layout_switch + 5000 < now) {
+                if (now - m_last_layout_switch > 5000) {
                     m_current_layout = LayoutB;
                     m_last_layout_switch = now;
                 }
                 break;
             case LayoutB:
-                if (m_last_layout_switch + 2000 < now) {
+                if (now - m_last_layout_switch > 2000) {
                     m_current_layout = LayoutA;
                     m_last_layout_switch = now;
                 }
@@ -256,7 +264,10 @@ void Ui::update()
             m_pico.draw(m_welcome_last, m_current_scroll_start, 63 - 6);
         }
 
-        m_display.flush();
+        {
+            TIMING(flush);
+            m_display.flush();
+        }
     } while (m_display.next_segment());
 
     if (*m_welcome_last != '\0') {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "clock.h"
 #include "controller.h"
 #include "display.h"
 #include "fonts.h"
@@ -91,6 +92,12 @@ public:
      */
     void set_full_burner_state(uint16_t);
 
+    /**
+     * Scroll @p message through the bottom line like the welcome message.
+     * The string must stay valid until it scrolled out.
+     */
+    void show_message(const char* message);
+
     /**
      * Update internal state and refresh display if necessary.
      */
@@ -102,7 +109,7 @@ private:
     bool m_layout_switching{false};
     bool m_freeze_layout{false};
     Layout m_current_layout{LayoutA};
-    unsigned long m_last_layout_switch{0};
+    Clock::Time m_last_layout_switch{0};
     uint8_t m_big_number_a{20};
     uint8_t m_small_number_a{20};
     uint8_t m_big_number_b{20};
@@ -110,7 +117,7 @@ private:
     uint8_t m_state{0};
     uint16_t m_full_burner_state{0};
     bool m_refresh{true};
-    unsigned long m_last_update{0};
+    Clock::Time m_last_update{0};
     const char* m_welcome{nullptr};
     const char* m_welcome_last{nullptr};
     uint8_t m_current_scroll_start{127};